@@ -4,6 +4,7 @@
 #include <expected>
 #include <fstream>
 #include <limits>
+#include <span>
 #include <sstream>
 #include <vector>
 
@@ -121,37 +122,6 @@ struct BitField {
     BitField(T value_, const int bitCount_) : value(value_), bitCount(bitCount_) {}
 };
 
-class BitReader {
-public:
-    BitReader() = default;
-    explicit BitReader(const std::vector<uint8_t>& bytes);
-    explicit BitReader(std::vector<uint8_t>&& bytes);
-
-    auto getBit() -> uint8_t;
-    auto getNBits(size_t numBits) -> uint64_t;
-    auto getUInt8() -> uint8_t;
-    auto getUInt16() -> uint16_t;
-    auto getUInt32() -> uint32_t;
-    auto getUInt64() -> uint64_t;
-
-    [[nodiscard]] auto peekBit() const -> uint8_t;
-    [[nodiscard]] auto peekNBits(size_t numBits) const -> uint64_t;
-    [[nodiscard]] auto peekUInt8() const -> uint8_t;
-    [[nodiscard]] auto peekUInt16() const -> uint16_t;
-    [[nodiscard]] auto peekUInt32() const -> uint32_t;
-    [[nodiscard]] auto peekUInt64() const -> uint64_t;
-
-    [[nodiscard]] auto reachedEnd() const -> bool;
-    auto skipBits(size_t numBits) -> void;
-    auto alignToByte() -> void;
-    auto addByte(uint8_t byte) -> void;
-private:
-    std::vector<uint8_t> m_bytes;
-    size_t m_byteIndex = 0;
-    size_t m_bitPosition = 0;
-};
-
-
 class BitWriter {
 public:
     explicit BitWriter(const std::string& filepath, size_t bufferSize = 4096);
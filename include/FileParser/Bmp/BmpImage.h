@@ -54,6 +54,15 @@ namespace FileParser::Bmp {
         std::vector<Color> colorTable;
     };
 
+    // The headers of a BMP, which is everything needed to know its dimensions and pixel format
+    struct ProbeInfo {
+        BmpHeader header;
+        BmpInfo info;
+    };
+
+    // Size of the file header plus the largest info header that parseInfo reads
+    inline constexpr size_t probeBytes = 14 + 40;
+
     auto calculateRowSize(uint16_t bitCount, uint32_t width) -> uint32_t;
 
     auto parseHeader(IO::ByteSpanReader& reader) -> std::expected<BmpHeader, std::string>;
@@ -66,5 +75,8 @@ namespace FileParser::Bmp {
     auto parseImageData8BitNoCompression(IO::ByteSpanReader reader, const BmpData& bmpData) -> std::expected<std::vector<uint8_t>, std::string>;
     auto parseImageData24Bit(IO::ByteSpanReader reader, const BmpData& bmpData) -> std::expected<std::vector<uint8_t>, std::string>;
 
+    auto probe(IO::ByteSpanReader& reader) -> std::expected<ProbeInfo, std::string>;
+    // Reads only the first probeBytes of the file
+    auto probe(const std::filesystem::path& filePath) -> std::expected<ProbeInfo, std::string>;
     auto decode(IO::ByteSpanReader& reader) -> std::expected<Image, std::string>;
 }
@@ -46,6 +46,9 @@ namespace FileParser::IO {
 
         [[nodiscard]] auto has_failed() const -> bool;
 
+        // The bytes from the current position to the end of the buffer, without consuming them
+        [[nodiscard]] auto remaining_bytes() const -> std::span<const uint8_t>;
+
         auto read_into(uint8_t *buffer, size_t len) -> void;
 
         template <typename T>
@@ -5,6 +5,7 @@
 #include <fstream>
 #include <span>
 #include <string>
+#include <vector>
 
 namespace FileUtils {
     inline constexpr uint8_t jpegSig[] = {0xFF, 0xD8, 0xFF};
@@ -18,8 +19,12 @@ namespace FileUtils {
     };
 
     auto getFileType(const std::string& filePath) -> FileType;
+    auto getFileType(std::span<const uint8_t> bytes) -> FileType;
     auto stringToFileType(const std::string& str) -> FileType;
     auto openRegularFile(const std::filesystem::path& filePath, std::ios::openmode mode) -> std::expected<std::ifstream, std::string>;
+    auto readFileBytes(const std::filesystem::path& filePath) -> std::expected<std::vector<uint8_t>, std::string>;
+    // Reads at most maxBytes from the start of the file. Fewer bytes are returned if the file is shorter
+    auto readFilePrefix(const std::filesystem::path& filePath, size_t maxBytes) -> std::expected<std::vector<uint8_t>, std::string>;
     auto openRegularFileForWrite(const std::filesystem::path& filePath, std::ios::openmode mode) -> std::expected<std::ofstream, std::string>;
 
     template <size_t N>
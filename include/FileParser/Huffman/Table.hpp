@@ -1,9 +1,9 @@
 #pragma once
 
 #include <array>
+#include <cstddef>
 #include <cstdint>
 #include <map>
-#include <memory>
 #include <vector>
 
 namespace FileParser {
@@ -16,38 +16,35 @@ namespace FileParser {
             : encoding(encoding_), bitLength(bitLength_), value(value_) {}
     };
 
-    struct HuffmanTableEntry;
-
-    struct HuffmanSubtable {
-        std::unique_ptr<std::array<HuffmanTableEntry, 256>> table = nullptr;
-
-        HuffmanSubtable() = default;
-
-        HuffmanSubtable(const HuffmanSubtable& other);
-        HuffmanSubtable& operator=(const HuffmanSubtable& other);
-
-        HuffmanSubtable(HuffmanSubtable&& other) = default;
-        HuffmanSubtable& operator=(HuffmanSubtable&& other) = default;
+    struct HuffmanLookupEntry {
+        uint8_t bitLength = 0; // 0 = the code is longer than the lookup table, or does not exist
+        uint8_t value = 0;
     };
 
-    struct HuffmanTableEntry {
-        uint8_t bitLength;
-        uint8_t value;
-        HuffmanSubtable nestedTable;
-
-        HuffmanTableEntry() : bitLength(0), value(0) {}
-        HuffmanTableEntry(const uint8_t bitLength_, const uint8_t value_) : bitLength(bitLength_), value(value_) {}
-        HuffmanTableEntry(const uint8_t bitLength_, const uint8_t value_, HuffmanSubtable table)
-        : bitLength(bitLength_), value(value_), nestedTable(std::move(table)) {}
+    // A symbol together with the extra bits that follow it, decoded by a single lookup
+    struct HuffmanFusedEntry {
+        uint8_t bitLength = 0; // Code length plus extra bits, 0 = both do not fit in the lookup table
+        uint8_t value = 0;
+        int16_t coefficient = 0;
     };
 
     class HuffmanTable {
     public:
         static constexpr size_t maxEncodingLength = 16;
+        // Codes up to this length are decoded with a single table lookup, longer ones go through m_maxCode
+        static constexpr size_t lookupBits = 9;
+        static constexpr size_t lookupSize = 1 << lookupBits;
 
         std::vector<HuffmanEncoding> encodings;
     private:
-        HuffmanSubtable m_table;
+        alignas(64) std::array<HuffmanLookupEntry, lookupSize> m_lookup{};
+        alignas(64) std::array<HuffmanFusedEntry, lookupSize> m_fusedLookup{};
+
+        // Canonical decoding for long codes: codes of length l are in [code - m_valueOffset[l], m_maxCode[l]]
+        std::array<int32_t, maxEncodingLength + 1> m_maxCode{};
+        std::array<int32_t, maxEncodingLength + 1> m_valueOffset{};
+        std::vector<uint8_t> m_values; // Symbols sorted by code
+
         std::map<uint8_t, HuffmanEncoding> m_encodingLookup;
     public:
         HuffmanTable() = default;
@@ -58,9 +55,26 @@ namespace FileParser {
 
         explicit HuffmanTable(const std::vector<HuffmanEncoding>& encodings_);
 
+        /**
+         * @param word The next 16 bits of the bitstream, left aligned.
+         * @return The bit length and symbol of the encoding at the start of word. A bit length of 0 means the bits do
+         * not start with any encoding in this table.
+         */
         [[nodiscard]] auto decode(uint16_t word) const -> std::pair<uint8_t, uint8_t>;
+
+        /**
+         * @brief Decodes a JPEG RRRRSSSS symbol together with the SSSS extra bits that follow it.
+         * @param word The next 16 bits of the bitstream, left aligned.
+         * @return The entry for the start of word. A bit length of 0 means the code and its extra bits do not fit in
+         * the lookup table, and decode has to be used instead.
+         */
+        [[nodiscard]] auto decodeFused(const uint16_t word) const -> const HuffmanFusedEntry& {
+            return m_fusedLookup[word >> (maxEncodingLength - lookupBits)];
+        }
         [[nodiscard]] auto encode(uint8_t symbol) const -> HuffmanEncoding;
     private:
         void generateLookupTable(const std::vector<HuffmanEncoding>& encodingsVec);
+        void generateFusedLookupTable();
+        void generateMaxCodeTable(const std::vector<HuffmanEncoding>& encodingsVec);
     };
 }
\ No newline at end of file
@@ -1,15 +1,37 @@
 #pragma once
+#include <cstddef>
 #include <cstdint>
 #include <vector>
 
 namespace FileParser {
+    // How the channels of each pixel are laid out in Image::data, in byte order
+    enum class PixelFormat : uint8_t {
+        RGB,
+        BGR,
+        RGBA,
+        BGRA,
+        Gray8
+    };
+
+    [[nodiscard]] constexpr auto getBytesPerPixel(const PixelFormat format) -> size_t {
+        switch (format) {
+            case PixelFormat::RGB:
+            case PixelFormat::BGR:   return 3;
+            case PixelFormat::RGBA:
+            case PixelFormat::BGRA:  return 4;
+            case PixelFormat::Gray8: return 1;
+        }
+        return 3;
+    }
+
     struct Image {
         uint32_t width = 0;
         uint32_t height = 0;
         std::vector<uint8_t> data;
+        PixelFormat format = PixelFormat::RGB;
 
-        Image(const uint32_t width_, const uint32_t height_, std::vector<uint8_t> data_)
-            : width(width_), height(height_), data(std::move(data_)) {}
+        Image(const uint32_t width_, const uint32_t height_, std::vector<uint8_t> data_, const PixelFormat format_ = PixelFormat::RGB)
+            : width(width_), height(height_), data(std::move(data_)), format(format_) {}
     };
 
     uint8_t& getPixel(Image& image, uint32_t x, uint32_t y, uint32_t channel);
@@ -0,0 +1,105 @@
+#pragma once
+
+#include <bit>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <span>
+
+#include "FileParser/Jpeg/Markers.hpp"
+
+namespace FileParser::Jpeg {
+    /**
+     * @brief Reads bits from entropy-coded data exactly as it is stored in the file.
+     *
+     * Stuffed 0xFF00 pairs are turned back into 0xFF while refilling, so the data never needs to be copied out first.
+     * Any other marker (an RST marker, or the marker following the scan) ends the data: from there on the reader
+     * supplies zero bits and reachedEnd turns true.
+     *
+     * Bit positions count bits of the unstuffed data, so they are independent of where the stuffed bytes are.
+     */
+    class BitReader {
+    public:
+        // Bits that can always be peeked without refilling
+        static constexpr size_t maxPeekBits = 56;
+
+        explicit BitReader(std::span<const uint8_t> bytes);
+
+        /**
+         * @param bytes The entropy-coded data.
+         * @param startByte Index into bytes to start reading from. Must not point at the 0x00 of a stuffed pair.
+         * @param startBitPosition The bit position of startByte within the unstuffed data.
+         */
+        BitReader(std::span<const uint8_t> bytes, size_t startByte, size_t startBitPosition);
+
+        [[nodiscard]] auto peekNBits(size_t numBits) const -> uint64_t;
+        [[nodiscard]] auto peekUInt16() const -> uint16_t;
+        auto skipBits(size_t numBits) -> void;
+        auto getNBits(size_t numBits) -> uint64_t;
+        auto alignToByte() -> void;
+
+        // True once every bit before the end of the data (or the first marker) has been read
+        [[nodiscard]] auto reachedEnd() const -> bool;
+        [[nodiscard]] auto getBitPosition() const -> size_t;
+    private:
+        static constexpr size_t bitsInByte = 8;
+        static constexpr size_t loadBytes  = sizeof(uint64_t);
+
+        std::span<const uint8_t> m_bytes;
+        size_t m_nextByte = 0; // Index into m_bytes of the next byte to load
+
+        uint64_t m_accumulator = 0; // Unread bits, left aligned
+        size_t m_bitCount = 0;      // Number of valid bits in m_accumulator
+        size_t m_loadedBytes = 0;   // Unstuffed bytes loaded so far, counting from the start of the data
+
+        // Bit position where the data ends, known once refilling has reached it
+        size_t m_endBitPosition = std::numeric_limits<size_t>::max();
+
+        auto refill() -> void;
+        auto refillSlow() -> void;
+    };
+
+    // Tops the accumulator up to at least 56 bits, with a single unaligned load when the next 8 bytes hold no 0xFF
+    inline auto BitReader::refill() -> void {
+        if (m_nextByte + loadBytes <= m_bytes.size()) {
+            uint64_t word;
+            std::memcpy(&word, m_bytes.data() + m_nextByte, loadBytes);
+            if constexpr (std::endian::native == std::endian::little) {
+                word = std::byteswap(word);
+            }
+            constexpr uint64_t lowBits  = 0x0101010101010101;
+            constexpr uint64_t highBits = 0x8080808080808080;
+            // Nonzero if any byte of word is 0xFF, i.e. if any byte of ~word is zero
+            if (((~word - lowBits) & word & highBits) == 0) [[likely]] {
+                const size_t bytes = (63 - m_bitCount) / bitsInByte;
+                m_accumulator |= word >> m_bitCount;
+                m_nextByte    += bytes;
+                m_loadedBytes += bytes;
+                m_bitCount    |= 56;
+                return;
+            }
+        }
+        refillSlow();
+    }
+
+    inline auto BitReader::peekNBits(const size_t numBits) const -> uint64_t {
+        if (numBits == 0) return 0;
+        return m_accumulator >> (64 - numBits);
+    }
+
+    inline auto BitReader::peekUInt16() const -> uint16_t {
+        return static_cast<uint16_t>(peekNBits(16));
+    }
+
+    inline auto BitReader::skipBits(const size_t numBits) -> void {
+        m_accumulator <<= numBits;
+        m_bitCount     -= numBits;
+        refill();
+    }
+
+    inline auto BitReader::getNBits(const size_t numBits) -> uint64_t {
+        const auto result = peekNBits(numBits);
+        skipBits(numBits);
+        return result;
+    }
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace FileParser::Jpeg {
+    // The coefficients of one 8x8 block, in natural (row-major) order rather than zigzag order
+    struct alignas(64) CoefficientBlock {
+        static constexpr size_t length = 64;
+        std::array<int16_t, length> coefficients{};
+
+        auto operator[](const size_t index) -> int16_t& { return coefficients[index]; }
+        auto operator[](const size_t index) const -> const int16_t& { return coefficients[index]; }
+    };
+
+    /**
+     * @brief The coefficients of every block of one image component, in a single 64-byte aligned allocation.
+     *
+     * Blocks are stored block-row-major: the first row of blocks from left to right, then the next row, and so on.
+     * The plane covers whole MCUs, so it can extend past the right and bottom edges of the image. Alongside each
+     * block it keeps the zigzag index of the block's last nonzero coefficient, which is 0 for blocks with only a DC
+     * coefficient, so the IDCT can take shortcuts for sparse blocks.
+     */
+    class CoefficientPlane {
+    public:
+        CoefficientPlane() = default;
+        CoefficientPlane(const size_t blocksPerLine, const size_t blockLines)
+            : m_blocksPerLine(blocksPerLine), m_blockLines(blockLines), m_blocks(blocksPerLine * blockLines),
+              m_lastNonzero(blocksPerLine * blockLines) {}
+
+        [[nodiscard]] auto getBlocksPerLine() const -> size_t { return m_blocksPerLine; }
+        [[nodiscard]] auto getBlockLines()    const -> size_t { return m_blockLines; }
+
+        auto getBlock(const size_t row, const size_t col) -> CoefficientBlock& {
+            return m_blocks[row * m_blocksPerLine + col];
+        }
+        [[nodiscard]] auto getBlock(const size_t row, const size_t col) const -> const CoefficientBlock& {
+            return m_blocks[row * m_blocksPerLine + col];
+        }
+
+        auto getLastNonzero(const size_t row, const size_t col) -> uint8_t& {
+            return m_lastNonzero[row * m_blocksPerLine + col];
+        }
+        [[nodiscard]] auto getLastNonzero(const size_t row, const size_t col) const -> uint8_t {
+            return m_lastNonzero[row * m_blocksPerLine + col];
+        }
+
+        [[nodiscard]] auto getBlocks() const -> std::span<const CoefficientBlock> { return m_blocks; }
+
+        // Zeroes every coefficient, so the plane can be decoded into again
+        auto clear() -> void {
+            std::ranges::fill(m_blocks, CoefficientBlock{});
+            std::ranges::fill(m_lastNonzero, uint8_t{0});
+        }
+        // Zeroes count block lines starting at firstLine
+        auto clearBlockLines(const size_t firstLine, const size_t count) -> void {
+            const auto first = static_cast<std::ptrdiff_t>(firstLine * m_blocksPerLine);
+            std::fill_n(m_blocks.begin() + first, count * m_blocksPerLine, CoefficientBlock{});
+            std::fill_n(m_lastNonzero.begin() + first, count * m_blocksPerLine, uint8_t{0});
+        }
+    private:
+        size_t m_blocksPerLine = 0;
+        size_t m_blockLines    = 0;
+        std::vector<CoefficientBlock> m_blocks; // std::allocator honours the 64-byte alignment of CoefficientBlock
+        std::vector<uint8_t> m_lastNonzero;     // Indexed like m_blocks
+    };
+}
@@ -0,0 +1,18 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "FileParser/Image.hpp"
+
+namespace FileParser::Jpeg {
+    /**
+     * @brief Converts one row of YCbCr samples to packed pixels with the JFIF equations in 14-bit fixed point.
+     *
+     * Results are rounded to nearest and saturated to [0, 255], and alpha is opaque. Gray8 is the Y samples unchanged,
+     * so cb and cr are not read. The kernel is picked on first use: AVX2 converts 32 pixels per iteration where the
+     * processor has it, and SSE2 converts 16 everywhere else.
+     * @param out Receives count pixels in format.
+     */
+    auto convertYCbCrRow(const uint8_t* y, const uint8_t* cb, const uint8_t* cr, size_t count, PixelFormat format, uint8_t* out) -> void;
+}
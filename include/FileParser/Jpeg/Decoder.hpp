@@ -3,12 +3,18 @@
 #include <array>
 #include <expected>
 #include <filesystem>
+#include <functional>
+#include <optional>
+#include <span>
+#include <string_view>
+#include <variant>
 #include <vector>
 
-#include "FileParser/BitManipulationUtil.h"
+#include "FileParser/ByteReader.hpp"
+#include "FileParser/Jpeg/BitReader.hpp"
 #include "FileParser/Image.hpp"
 #include "FileParser/Huffman/Table.hpp"
-#include "FileParser/Jpeg/Mcu.hpp"
+#include "FileParser/Jpeg/CoefficientPlane.hpp"
 #include "FileParser/Jpeg/Structures.hpp"
 
 namespace FileParser::Jpeg {
@@ -40,15 +46,28 @@ namespace FileParser::Jpeg {
         std::array<std::vector<HuffmanTable>, 4> ac;
     };
 
+    // Errors from decoding entropy-coded data. They are cheap to return, so failed speculative decodes cost nothing extra
+    enum class DecodeError : uint8_t {
+        InvalidHuffmanCode,
+        InvalidDcCategory,
+        InvalidAcCategory,
+        RunLengthOverflow
+    };
+
+    [[nodiscard]] auto toString(DecodeError error) -> std::string_view;
+
     struct ACCoefficientResult {
         int r;
         int s;
+        int coefficient; // The decoded SSSS extra bits, 0 when s is 0
     };
 
     using QuantizationTablePtrs = std::array<const QuantizationTable *, MaxTableId>;
     using HuffmanTablePtrs      = std::array<const HuffmanTable *,      MaxTableId>;
 
     struct JpegData {
+        // The whole file when it was read by parseFile. Data sections of each scan are offsets into the parsed bytes
+        std::vector<uint8_t> bytes;
         FrameInfo frameInfo;
         uint16_t lastSetRestartInterval = 0;
         std::vector<Scan> scans;
@@ -58,66 +77,383 @@ namespace FileParser::Jpeg {
         HuffmanTables huffmanTables;
     };
 
-    using PreviousDC = std::map<int, int>;
+    // What the headers say about an image, without any of its tables or entropy-coded data
+    struct ProbeInfo {
+        uint8_t frameMarker = 0; // The SOF marker, which tells baseline, extended and progressive frames apart
+        FrameHeader frameHeader; // Dimensions and the identifier and sampling factors of each component
+        ScanHeader firstScan;    // Baseline images whose first scan holds every component have no further scans
+    };
+
+    // The DC predictor of each component of a scan, indexed by its position in the scan header
+    using PreviousDC = std::array<int, MaxScanComponents>;
+
+    // A quantization table in zigzag order, so coefficients can be dequantized as they are decoded
+    struct DequantizationTable {
+        std::array<int16_t, CoefficientBlock::length> multipliers{};
+
+        auto operator[](const size_t index) const -> int16_t { return multipliers[index]; }
+    };
+
+    // The dequantization table of each component of a scan, indexed by its position in the scan header
+    using DequantizationTables = std::array<DequantizationTable, MaxScanComponents>;
+
+    // One block of an MCU: the scan component it is coded with, and where it is stored in the coefficient planes
+    struct McuBlock {
+        size_t scanComponentIndex = 0;
+        size_t planeIndex = 0; // Planes are in the order of the components in the frame header
+        size_t rowOffset  = 0; // Position of the block within the MCU, in blocks
+        size_t colOffset  = 0;
+        size_t horizontalSamplingFactor = 1; // Size of the MCU in blocks of this component
+        size_t verticalSamplingFactor   = 1;
+        bool skipped = false; // Entropy decoded without keeping its coefficients, as the output never reads them
+        bool dcOnly  = false; // Only the DC coefficient is kept, as the block is transformed to a single sample
+    };
+
+    // The blocks of an MCU in the order they are stored in the bitstream
+    using McuLayout = std::vector<McuBlock>;
+
+    // How many times smaller than the image to decode it, in each dimension
+    enum class DecodeScale : uint8_t {
+        Full    = 1,
+        Half    = 2,
+        Quarter = 4,
+        Eighth  = 8
+    };
+
+    // The size of a dimension of the image once decoded at scale, rounding up
+    [[nodiscard]] constexpr auto getScaledSize(const size_t size, const DecodeScale scale) -> size_t {
+        const auto denominator = static_cast<size_t>(scale);
+        return (size + denominator - 1) / denominator;
+    }
+
+    // A rectangle of the decoded image, in pixels of the image at the decode scale
+    struct Region {
+        uint32_t x = 0;
+        uint32_t y = 0;
+        uint32_t width  = 0;
+        uint32_t height = 0;
+    };
+
+    // How subsampled chroma is stretched back to the size of the image
+    enum class Upsampling : uint8_t {
+        Nearest, // Each chroma sample covers its pixels unchanged
+        Fancy    // Triangle filter between neighbouring chroma samples, as libjpeg does by default. Smoother but slower
+    };
+
+    struct DecodeOptions {
+        // Scaled decodes use smaller IDCTs instead of decoding at full size and downscaling. At 1/8 a block is one
+        // pixel, its DC coefficient, so the AC coefficients of those blocks are walked past without being decoded
+        DecodeScale scale = DecodeScale::Full;
+        Upsampling upsampling = Upsampling::Nearest;
+        // Gray8 is the luma plane alone. Chroma is entropy decoded, as the bitstream requires, but nothing else
+        PixelFormat format = PixelFormat::RGB;
+        // Decodes only this part of the image, which must lie inside it. The output is the size of the region
+        std::optional<Region> region;
+    };
+
+    // Receives one row of pixels in the format of the options, numbered from the top of the image, or of the region when there is one
+    using ScanlineSink = std::function<void(size_t row, std::span<const uint8_t> scanline)>;
+
+    // Memory owned by the caller to decode pixels into
+    struct OutputBuffer {
+        uint8_t* data = nullptr;
+        size_t stride = 0; // Bytes from the start of one row to the start of the next, at least a whole row of pixels
+        size_t size   = 0; // Bytes available at data. The last row only has to fit its pixels, not a whole stride
+    };
+
+    // One component of a planar image, with rows packed width bytes apart
+    struct ImagePlane {
+        uint32_t width  = 0;
+        uint32_t height = 0;
+        std::vector<uint8_t> data;
+    };
+
+    // The components of a YCbCr image as decoded, before chroma is upsampled or anything is color converted
+    struct YCbCrImage {
+        ImagePlane y;
+        ImagePlane cb; // Chroma planes are smaller than y by the chroma subsampling of the frame
+        ImagePlane cr;
+    };
+
+    // One component of a frame as quantized DCT coefficients, with the tables it was coded with
+    struct ComponentCoefficients {
+        FrameComponent component; // Identifier, sampling factors and quantization table selector
+        QuantizationTable quantizationTable;
+        HuffmanTable dcTable;
+        HuffmanTable acTable;
+        // Quantized coefficients in natural order, covering whole MCUs. DC coefficients are absolute, not differences
+        CoefficientPlane plane;
+    };
+
+    // The entropy decoded contents of a baseline frame, before anything is dequantized or transformed
+    struct CoefficientImage {
+        FrameHeader frameHeader;
+        uint32_t mcuWidth  = 0; // MCUs in each row and column of the planes
+        uint32_t mcuHeight = 0;
+        uint16_t restartInterval = 0; // MCUs between restart markers, 0 when there are none
+        std::vector<ComponentCoefficients> components; // In frame header order
+    };
 
     class Parser {
-        [[nodiscard]] static auto parseFrameComponent(std::ifstream& file) -> std::expected<FrameComponent, std::string>;
-        [[nodiscard]] static auto parseFrameHeader(std::ifstream& file, uint8_t SOF) -> std::expected<FrameHeader, std::string>;
-        [[nodiscard]] static auto parseDNL(std::ifstream& file) -> std::expected<uint16_t, std::string>;
-        [[nodiscard]] static auto parseDRI(std::ifstream& file) -> std::expected<uint16_t, std::string>;
-        [[nodiscard]] static auto parseComment(std::ifstream& file) -> std::expected<std::string, std::string>;
-        [[nodiscard]] static auto parseDQT(std::ifstream& file) -> std::expected<std::vector<QuantizationTable>, std::string>;
-        [[nodiscard]] static auto parseDHT(std::ifstream& file) -> std::expected<std::vector<HuffmanParseResult>, std::string>;
-        [[nodiscard]] static auto parseScanHeaderComponent(std::ifstream& file) -> std::expected<ScanComponent, std::string>;
-        [[nodiscard]] static auto parseScanHeader(std::ifstream& file) -> std::expected<ScanHeader, std::string>;
-        [[nodiscard]] static auto parseECS(std::ifstream& file) -> std::expected<std::vector<std::vector<uint8_t>>, std::string>;
-        [[nodiscard]] static auto parseSOS(std::ifstream& file) -> std::expected<Scan, std::string>;
-        [[nodiscard]] static auto parseEOI(std::ifstream& file) -> std::expected<void, std::string>;
+        [[nodiscard]] static auto parseFrameComponent(IO::ByteSpanReader& reader) -> std::expected<FrameComponent, std::string>;
+        [[nodiscard]] static auto parseFrameHeader(IO::ByteSpanReader& reader) -> std::expected<FrameHeader, std::string>;
+        [[nodiscard]] static auto parseDNL(IO::ByteSpanReader& reader) -> std::expected<uint16_t, std::string>;
+        [[nodiscard]] static auto parseDRI(IO::ByteSpanReader& reader) -> std::expected<uint16_t, std::string>;
+        [[nodiscard]] static auto parseComment(IO::ByteSpanReader& reader) -> std::expected<std::string, std::string>;
+        [[nodiscard]] static auto parseDQT(IO::ByteSpanReader& reader) -> std::expected<std::vector<QuantizationTable>, std::string>;
+        [[nodiscard]] static auto parseDHT(IO::ByteSpanReader& reader) -> std::expected<std::vector<HuffmanParseResult>, std::string>;
+        [[nodiscard]] static auto parseScanHeaderComponent(IO::ByteSpanReader& reader) -> std::expected<ScanComponent, std::string>;
+        [[nodiscard]] static auto parseScanHeader(IO::ByteSpanReader& reader) -> std::expected<ScanHeader, std::string>;
+        [[nodiscard]] static auto parseECS(IO::ByteSpanReader& reader) -> std::expected<std::vector<DataSection>, std::string>;
+        [[nodiscard]] static auto parseSOS(IO::ByteSpanReader& reader) -> std::expected<Scan, std::string>;
+        [[nodiscard]] static auto parseEOI(const IO::ByteSpanReader& reader) -> std::expected<void, std::string>;
+        // Jumps over a segment using its length field, for APPn and other segments that are not used for decoding
+        [[nodiscard]] static auto skipSegment(IO::ByteSpanReader& reader) -> std::expected<void, std::string>;
 
         [[nodiscard]] static auto analyzeFrameHeader(const FrameHeader& header, uint8_t SOF) -> std::expected<FrameInfo, std::string>;
     public:
+        // The data sections of the scans point into bytes, which must outlive the returned data
+        [[nodiscard]] static auto parse(std::span<const uint8_t> bytes) -> std::expected<JpegData, std::string>;
         [[nodiscard]] static auto parseFile(const std::filesystem::path& filePath) -> std::expected<JpegData, std::string>;
+        // Parses the frame header and the first scan header, skipping every other segment. Nothing past the first SOS is read
+        [[nodiscard]] static auto probe(std::span<const uint8_t> bytes) -> std::expected<ProbeInfo, std::string>;
+        // As above, and sets truncated when probing failed only because bytes ended before the first SOS segment did
+        [[nodiscard]] static auto probe(std::span<const uint8_t> bytes, bool& truncated) -> std::expected<ProbeInfo, std::string>;
     };
 
+    /**
+     * @brief Reads the dimensions and component layout of a Jpeg without decoding it.
+     *
+     * Only the start of the file is read, and more of it only when the segments before the first SOS do not fit.
+     */
+    [[nodiscard]] auto probe(const std::filesystem::path& filePath) -> std::expected<ProbeInfo, std::string>;
+
     class Decoder {
+        // Scans without restart markers are only split for speculative decoding if every chunk gets at least this much data
+        static constexpr size_t minSpeculativeChunkBytes = 64 * 1024;
+
         [[nodiscard]] static auto isEOB(int r, int s) -> bool;
         [[nodiscard]] static auto isZRL(int r, int s) -> bool;
 
         // Given the SSSS category, read that many bits from the BitReader and decode its value
         [[nodiscard]] static auto decodeSSSS         (BitReader& bitReader, int SSSS) -> int;
-        [[nodiscard]] static auto decodeNextValue    (BitReader& bitReader, const HuffmanTable& huffmanTable) -> uint8_t;
-        [[nodiscard]] static auto decodeDcCoefficient(BitReader& bitReader, const HuffmanTable& huffmanTable) -> int;
-        [[nodiscard]] static auto decodeAcCoefficient(BitReader& bitReader, const HuffmanTable& huffmanTable) -> ACCoefficientResult;
+        [[nodiscard]] static auto decodeNextValue    (BitReader& bitReader, const HuffmanTable& huffmanTable) -> std::expected<uint8_t, DecodeError>;
+        [[nodiscard]] static auto decodeDcCoefficient(BitReader& bitReader, const HuffmanTable& huffmanTable) -> std::expected<int, DecodeError>;
+        // Decodes an RRRRSSSS symbol and its extra bits, with one table lookup when both fit in HuffmanTable::lookupBits
+        [[nodiscard]] static auto decodeAcCoefficient(BitReader& bitReader, const HuffmanTable& huffmanTable) -> std::expected<ACCoefficientResult, DecodeError>;
 
+        // Checks that the scan has a data section for every restart interval and returns how many sections there are
+        [[nodiscard]] static auto countDataSections(const FrameInfo& frame, const Scan& scan) -> std::expected<size_t, std::string>;
+        // Creates one zeroed plane per frame component, each covering mcuLines rows of MCUs. Chroma planes are left
+        // empty when lumaOnly is set
+        [[nodiscard]] static auto createPlanes(const FrameInfo& frame, size_t mcuLines, bool lumaOnly = false) -> std::vector<CoefficientPlane>;
+        // The blocks of an MCU, marking the blocks that decoding at scale reads only the DC coefficient of, and the
+        // chroma blocks as skipped when lumaOnly is set
+        [[nodiscard]] static auto getMcuLayout(
+            const FrameInfo& frame, const ScanHeader& scanHeader, DecodeScale scale = DecodeScale::Full, bool lumaOnly = false) -> McuLayout;
+        [[nodiscard]] static auto getBlock(
+            std::span<CoefficientPlane> planes, const FrameInfo& frame, size_t mcuIndex, const McuBlock& block) -> CoefficientBlock&;
+        [[nodiscard]] static auto getLastNonzero(
+            std::span<CoefficientPlane> planes, const FrameInfo& frame, size_t mcuIndex, const McuBlock& block) -> uint8_t&;
+
+        [[nodiscard]] static auto createDequantizationTables(
+            const FrameInfo& frame,
+            const ScanHeader& scanHeader,
+            const QuantizationTablePtrs& quantizationTables) -> std::expected<DequantizationTables, std::string>;
+
+        /**
+         * @brief Decodes the coefficients of a single block, dequantizing the AC coefficients as they are placed.
+         *
+         * The DC coefficient is left quantized, as the difference from the previous block, since the predictor works
+         * on quantized values.
+         * @param lastNonzero Receives the zigzag index of the last nonzero AC coefficient placed, if any.
+         * @param dcOnly Walks the AC coefficients with skipAcCoefficients instead of placing them.
+         */
+        [[nodiscard]] static auto decodeBlock(
+            CoefficientBlock& out,
+            uint8_t& lastNonzero,
+            BitReader& bitReader,
+            const HuffmanTable& dcTable,
+            const HuffmanTable& acTable,
+            const DequantizationTable& dequantizationTable,
+            bool dcOnly = false) -> std::expected<void, DecodeError>;
+
+        // Walks the AC symbols of a block, with the same checks as decodeBlock, without extending or storing their values
+        [[nodiscard]] static auto skipAcCoefficients(BitReader& bitReader, const HuffmanTable& acTable) -> std::expected<void, DecodeError>;
+
+        // Walks the Huffman symbols of a whole block without keeping anything
+        [[nodiscard]] static auto skipBlock(
+            BitReader& bitReader,
+            const HuffmanTable& dcTable,
+            const HuffmanTable& acTable) -> std::expected<void, DecodeError>;
+
+        // Decodes a single block and resolves its DC coefficient against prevDc, leaving the block fully dequantized
         [[nodiscard]] static auto decodeComponent(
-            Component& out,
+            CoefficientBlock& out,
+            uint8_t& lastNonzero,
             BitReader& bitReader,
             const ScanComponent& scanComp,
             const HuffmanTablePtrs& dcTables,
-            const HuffmanTablePtrs& acTables, PreviousDC& prevDc) -> std::expected<Component, std::string>;
+            const HuffmanTablePtrs& acTables,
+            const DequantizationTable& dequantizationTable,
+            bool dcOnly,
+            int& prevDc) -> std::expected<void, DecodeError>;
+
+        // Entropy decodes an MCU without keeping it, which keeps the bitstream position and DC predictors right
+        [[nodiscard]] static auto skipMcu(
+            BitReader& bitReader,
+            const ScanHeader& scanHeader,
+            const McuLayout& layout,
+            const HuffmanTablePtrs& dcTables,
+            const HuffmanTablePtrs& acTables,
+            PreviousDC& prevDc) -> std::expected<void, DecodeError>;
 
         [[nodiscard]] static auto decodeMcu(
+            std::span<CoefficientPlane> planes,
+            size_t mcuIndex,
             BitReader& bitReader,
             const FrameInfo& frame,
             const ScanHeader& scanHeader,
+            const McuLayout& layout,
             const HuffmanTablePtrs& dcTables,
             const HuffmanTablePtrs& acTables,
-            PreviousDC& prevDc) -> std::expected<Mcu, std::string>;
+            const DequantizationTables& dequantizationTables,
+            PreviousDC& prevDc) -> std::expected<void, DecodeError>;
 
+        // Checks that only padding is left of a restart interval once its last MCU is decoded
+        [[nodiscard]] static auto finishRSTSegment(BitReader& bitReader) -> std::expected<void, std::string>;
+
+        // Decodes one restart interval, which covers the mcuCount MCUs starting at firstMcu
         [[nodiscard]] static auto decodeRSTSegment(
+            std::span<CoefficientPlane> planes,
+            size_t firstMcu,
+            size_t mcuCount,
+            const FrameInfo& frame,
+            const ScanHeader& scanHeader,
+            const McuLayout& layout,
+            const HuffmanTablePtrs& dcTables,
+            const HuffmanTablePtrs& acTables,
+            const DequantizationTables& dequantizationTables,
+            std::span<const uint8_t> rstData) -> std::expected<void, std::string>;
+
+        /**
+         * @brief Decodes a scan without restart markers by splitting its data into chunkCount pieces decoded in parallel.
+         *
+         * Each chunk starts decoding at a guessed position, assuming it is the start of an MCU. Huffman codes usually
+         * resynchronize within a few blocks, so once the real decoding reaches a block that a chunk decoded at the same
+         * position and as the same block of an MCU, the rest of that chunk is taken as is. Anything a chunk got wrong is
+         * decoded serially, so the output is always identical to decoding the scan from start to end.
+         */
+        [[nodiscard]] static auto decodeSpeculatively(
+            std::span<CoefficientPlane> planes,
             const FrameInfo& frame,
             const ScanHeader& scanHeader,
+            const McuLayout& layout,
             const HuffmanTablePtrs& dcTables,
             const HuffmanTablePtrs& acTables,
-            uint16_t restartInterval,
-            const std::vector<uint8_t>& rstData) -> std::expected<std::vector<Mcu>, std::string>;
+            const DequantizationTables& dequantizationTables,
+            std::span<const uint8_t> data,
+            size_t chunkCount) -> std::expected<void, std::string>;
 
+        /**
+         * @brief Decodes a scan into one plane of dequantized coefficients per frame component, in frame header order.
+         *
+         * Restart intervals are independent of each other, so they are decoded in parallel on the shared thread pool.
+         * @param scale The scale the planes will be transformed at. Blocks transformed to a single sample keep only
+         * their DC coefficient.
+         * @param lumaOnly Leaves the chroma planes empty. Chroma is still entropy decoded, since the bitstream
+         * interleaves it with luma, but never dequantized or stored.
+         */
+        [[nodiscard]] static auto decodeScan(
+            const FrameInfo& frame,
+            const Scan& scan,
+            std::span<const uint8_t> fileBytes,
+            const HuffmanTablePtrs& dcTables,
+            const HuffmanTablePtrs& acTables,
+            const DequantizationTables& dequantizationTables,
+            DecodeScale scale = DecodeScale::Full,
+            bool lumaOnly = false) -> std::expected<std::vector<CoefficientPlane>, std::string>;
+        // Decodes a scan as above, but splits a scan without restart markers into chunkCount speculative chunks
+        // instead of one per thread. A chunkCount of 1 decodes it serially
         [[nodiscard]] static auto decodeScan(
             const FrameInfo& frame,
             const Scan& scan,
+            std::span<const uint8_t> fileBytes,
             const HuffmanTablePtrs& dcTables,
-            const HuffmanTablePtrs& acTables) -> std::expected<std::vector<Mcu>, std::string>;
+            const HuffmanTablePtrs& acTables,
+            const DequantizationTables& dequantizationTables,
+            DecodeScale scale,
+            bool lumaOnly,
+            size_t chunkCount) -> std::expected<std::vector<CoefficientPlane>, std::string>;
+
+        // Where decodeRegionRows puts finished rows: straight into a caller's buffer, or through a scratch buffer to a sink
+        using RowOutput = std::variant<OutputBuffer, const ScanlineSink*>;
+
+        // Decodes the region of options, or the whole image, one MCU row at a time as decodeRows describes
+        [[nodiscard]] static auto decodeRegionRows(
+            const JpegData& data, std::span<const uint8_t> bytes, const RowOutput& output, const DecodeOptions& options)
+            -> std::expected<void, std::string>;
+        // Decodes the region of options, or the whole image, into output, which has been checked to be large enough
+        [[nodiscard]] static auto decodeIntoBuffer(
+            const JpegData& data, std::span<const uint8_t> bytes, const OutputBuffer& output, const DecodeOptions& options)
+            -> std::expected<void, std::string>;
     public:
-        [[nodiscard]] static auto decode(const std::filesystem::path& filePath) -> std::expected<Image, std::string>;
+        [[nodiscard]] static auto decode(
+            std::span<const uint8_t> bytes, const DecodeOptions& options = {}) -> std::expected<Image, std::string>;
+        [[nodiscard]] static auto decode(
+            const std::filesystem::path& filePath, const DecodeOptions& options = {}) -> std::expected<Image, std::string>;
+
+        /**
+         * @brief Decodes into separate Y, Cb and Cr planes at their own resolutions, for video encoders and GPU upload
+         * paths that take YUV directly and would otherwise undo the upsampling and color conversion.
+         *
+         * Chroma keeps the resolution it was sampled at, rounded up, except that scaled decodes shrink chroma less
+         * than luma where the MCU allows, as they do for packed formats. The format and upsampling of options are
+         * ignored, and regions are not supported.
+         */
+        [[nodiscard]] static auto decodePlanar(
+            std::span<const uint8_t> bytes, const DecodeOptions& options = {}) -> std::expected<YCbCrImage, std::string>;
+
+        /**
+         * @brief Entropy decodes the image and stops, returning the quantized coefficients of each component along
+         * with its quantization and Huffman tables.
+         *
+         * This is everything that lossless rotation, requantization or re-encoding of coefficients needs, without
+         * paying for dequantization, the IDCT or color conversion.
+         */
+        [[nodiscard]] static auto decodeCoefficients(std::span<const uint8_t> bytes) -> std::expected<CoefficientImage, std::string>;
+
+        /**
+         * @brief Decodes a scan without restart markers both serially and speculatively in chunkCount chunks, and
+         * reports the first block where the two differ.
+         *
+         * decode only speculates on large scans when there is more than one thread, so this exercises it on any file
+         * and any host.
+         */
+        [[nodiscard]] static auto checkSpeculativeDecode(
+            std::span<const uint8_t> bytes, size_t chunkCount) -> std::expected<void, std::string>;
+
+        /**
+         * @brief Decodes straight into memory owned by the caller, such as a pooled or memory mapped buffer or a
+         * rectangle of a larger canvas, without any intermediate image.
+         *
+         * Rows are written output.stride bytes apart, and the bytes between the end of one row and the start of the
+         * next are left untouched. The output must fit the decoded size, which is the size of the region when there is
+         * one and otherwise getScaledSize of the dimensions that probe reads.
+         */
+        [[nodiscard]] static auto decodeInto(
+            std::span<const uint8_t> bytes, const OutputBuffer& output, const DecodeOptions& options = {}) -> std::expected<void, std::string>;
+
+        /**
+         * @brief Decodes one MCU row at a time and passes each finished scanline to sink, from top to bottom.
+         *
+         * Only one MCU row of coefficients and pixels is held at once, so memory grows with the width of the image
+         * instead of its area. Decoding is serial. Rows already passed to sink stay delivered when a later row fails.
+         *
+         * With a region, MCUs outside it are entropy decoded but never transformed or color converted, restart
+         * intervals outside it are skipped entirely, and decoding stops after the last MCU row the region needs.
+         */
+        [[nodiscard]] static auto decodeRows(
+            std::span<const uint8_t> bytes, const ScanlineSink& sink, const DecodeOptions& options = {}) -> std::expected<void, std::string>;
     };
 }
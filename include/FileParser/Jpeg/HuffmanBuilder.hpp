@@ -3,24 +3,24 @@
 #include <expected>
 #include <string>
 
+#include "FileParser/ByteReader.hpp"
 #include "FileParser/Huffman/Table.hpp"
 
 namespace FileParser::Jpeg {
     class HuffmanBuilder {
         public:
             /**
-             * @brief Reads a single Huffman table from a JPEG file stream.
+             * @brief Reads a single Huffman table from the data of a DHT marker segment.
              *
-             * Parses Huffman table data starting at the specified file offset. This reads exactly one Huffman table
-             * from the DHT marker segment.
+             * This reads exactly one Huffman table, starting at the current position of the reader.
              *
-             * @param file The input file stream pointing to the JPEG file.
-             * @return A HuffmanTable constructed from the parsed file data
+             * @param reader A reader over the JPEG file, positioned at the start of the table.
+             * @return A HuffmanTable constructed from the parsed data
              *
-             * @note If the DHT segment contains multiple Huffman tables, call this function repeatedly, updating the
-             * file position each time, to read each table in sequence
+             * @note If the DHT segment contains multiple Huffman tables, call this function repeatedly to read each
+             * table in sequence
              */
-            static auto readFromFile(std::ifstream& file) -> std::expected<HuffmanTable, std::string>;
+            static auto readFromBytes(IO::ByteSpanReader& reader) -> std::expected<HuffmanTable, std::string>;
 
             /**
              * @param symbols The list of symbols to be encoded.
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "FileParser/Jpeg/CoefficientPlane.hpp"
+
+namespace FileParser::Jpeg {
+    /**
+     * @brief Fixed-point inverse DCT of one block. Both passes and the transposes stay in SSE2 registers.
+     *
+     * Values are 16-bit between the passes, with 32-bit products, which matches the accuracy of the libjpeg
+     * "islow" IDCT. Sparse blocks take shortcuts picked by lastNonzero: DC-only blocks are a single fill, and blocks
+     * within the top left 4x4 coefficients skip the terms of the other frequencies. Both give the same samples as the
+     * full transform.
+     * @param block Dequantized coefficients.
+     * @param lastNonzero Zigzag index of the last nonzero coefficient of block.
+     * @param out Receives the 8x8 samples, level shifted and clamped to [0, 255].
+     * @param stride Bytes between the rows of out.
+     */
+    auto inverseDCT(const CoefficientBlock& block, uint8_t lastNonzero, uint8_t* out, size_t stride) -> void;
+
+    /**
+     * @brief Reduced inverse DCT for scaled decoding, using only the top left size x size coefficients.
+     *
+     * The size x size samples it writes approximate the full samples averaged over squares of 8 / size pixels.
+     * @param size 1, 2, 4 or 8. Size 8 is the full inverseDCT, and size 1 needs only the DC coefficient.
+     */
+    auto inverseDCT(const CoefficientBlock& block, uint8_t lastNonzero, size_t size, uint8_t* out, size_t stride) -> void;
+
+    // The reduced inverse DCT of the block of plane at row and col
+    auto inverseDCT(const CoefficientPlane& plane, size_t row, size_t col, size_t size, uint8_t* out, size_t stride) -> void;
+}
@@ -0,0 +1,15 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+
+namespace FileParser::Jpeg {
+    /**
+     * @brief Finds the next 0xFF byte, checking 32 bytes at a time with SIMD compares.
+     * @param bytes The bytes to search.
+     * @param from Index to start searching from.
+     * @return The index of the first 0xFF at or after from, or bytes.size() if there is none.
+     */
+    [[nodiscard]] auto findMarkerHeader(std::span<const uint8_t> bytes, size_t from) -> size_t;
+}
@@ -1,6 +1,8 @@
 #pragma once
 
 #include <cstdint>
+#include <format>
+#include <stdexcept>
 
 namespace FileParser::Jpeg {
     constexpr uint8_t MarkerHeader = 0xFF;
@@ -101,6 +103,11 @@ namespace FileParser::Jpeg {
         return marker >= RST0 && marker <= RST7;
     }
 
+    // Markers without a segment. Every other marker is followed by a segment that starts with its length
+    inline auto isStandalone(const uint8_t marker) -> bool {
+        return marker == SOI || marker == EOI || marker == TEM || isRST(marker);
+    }
+
     inline auto getNextRST(const uint8_t marker) -> uint8_t {
         if (!isRST(marker)) throw std::invalid_argument(std::format("Marker {} is not an RST", marker));
         if (marker == RST7) return RST0;
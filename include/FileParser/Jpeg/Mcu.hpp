@@ -29,9 +29,5 @@ namespace FileParser::Jpeg {
         Mcu();
         Mcu(int horizontalSampleSize_, int verticalSampleSize_);
         explicit Mcu(const RGBBlock& colorBlock);
-
-        // Given the index of the luminance block and the pixel index (0-63) within that block, get the index to the
-        // corresponding pixel in Cb and Cr
-        [[nodiscard]] size_t getColorIndex(size_t blockIndex, size_t pixelIndex) const;
     };
 }
@@ -1,10 +1,16 @@
 #pragma once
 
+#include <algorithm>
+#include <array>
 #include <cstdint>
+#include <expected>
+#include <format>
+#include <string>
 #include <vector>
 
 namespace FileParser::Jpeg {
     constexpr size_t MaxTableId = 4;
+    constexpr size_t MaxScanComponents = 4;
 
     struct FrameComponent {
         uint8_t identifier = 0;
@@ -53,11 +59,17 @@ namespace FileParser::Jpeg {
         std::array<size_t, MaxTableId> ac{};
     };
 
+    // Where a piece of entropy-coded data is in the file. The bytes are still byte stuffed
+    struct DataSection {
+        size_t offset = 0;
+        size_t length = 0;
+    };
+
     struct Scan {
         ScanHeader header;
         uint16_t restartInterval = 0;
         TableIterations iterations;
-        std::vector<std::vector<uint8_t>> dataSections; // Sections of data separated at restart markers
+        std::vector<DataSection> dataSections; // Sections of data separated at restart markers
     };
 
     const unsigned char zigZagMap[] = {
@@ -2,6 +2,7 @@
 
 #include <cmath>
 #include <numbers>
+#include <optional>
 
 #include "Decoder.hpp"
 #include "Mcu.hpp"
@@ -27,7 +28,6 @@ namespace FileParser::Jpeg {
     const float s7 = static_cast<float>(std::cos(7.0 / 16.0 * std::numbers::pi) / 2.0);
 
     void inverseDCT(Component& array);
-    void inverseDCT(Mcu& mcu);
 
     void forwardDCT(Component& component);
     void forwardDCT(Mcu& mcu);
@@ -37,9 +37,6 @@ namespace FileParser::Jpeg {
 
     void dequantize(Component& component, const QuantizationTable& quantizationTable);
 
-    std::expected<void, std::string> dequantize(Mcu& mcu, const FrameInfo& frame, const ScanHeader& scanHeader,
-                                                const std::array<const QuantizationTable *, 4>& quantizationTables);
-
     void quantize(Component& component,   const QuantizationTable& quantizationTable);
     void quantize(Mcu& mcu,               const QuantizationTable& luminanceTable, const QuantizationTable& chrominanceTable);
     void quantize(std::vector<Mcu>& mcus, const QuantizationTable& luminanceTable, const QuantizationTable& chrominanceTable);
@@ -51,7 +48,80 @@ namespace FileParser::Jpeg {
     auto YCbCrToRGB(float y, float cb, float cr) -> RGB;
     auto RGBToYCbCr(float r, float g, float b) -> YCbCr;
 
-    auto generateColorBlocks(const Mcu& mcu) -> std::vector<RGBBlock>;
-    auto convertMcusToColorBlocks(const std::vector<Mcu>& mcus, size_t pixelWidth, size_t pixelHeight) -> std::vector<RGBBlock>;
-    auto getRawRGBData(const std::vector<RGBBlock>& colorBlocks, size_t pixelWidth, size_t pixelHeight) -> std::vector<uint8_t>;
+    // The size of an MCU once decoded at a scale, in pixels, and of the chroma samples decoded for it
+    struct McuGeometry {
+        size_t blockSize  = 0; // Side of the samples of one luma block
+        size_t width      = 0;
+        size_t height     = 0;
+        size_t chromaSize = 0; // Side of the samples of one chroma block, which cover the whole MCU
+
+        // Pixels per chroma sample in each dimension
+        [[nodiscard]] auto horizontalRatio() const -> size_t { return width  / chromaSize; }
+        [[nodiscard]] auto verticalRatio()   const -> size_t { return height / chromaSize; }
+    };
+
+    [[nodiscard]] auto getMcuGeometry(const FrameInfo& frame, DecodeScale scale) -> McuGeometry;
+
+    // Whether upsampling reads chroma from the neighbouring MCU columns and MCU rows
+    [[nodiscard]] auto needsNeighbourColumns(const McuGeometry& geometry, Upsampling upsampling) -> bool;
+    [[nodiscard]] auto needsNeighbourRows(const McuGeometry& geometry, Upsampling upsampling) -> bool;
+
+    // Where in the coefficient planes an MCU row is, and the MCU rows above and below it when those are needed
+    struct PlaneRows {
+        size_t current = 0;
+        std::optional<size_t> above;
+        std::optional<size_t> below;
+    };
+
+    // Working rows of convertMcuRowToPixels, sized once per decode so that converting an MCU row does not allocate
+    struct McuRowScratch {
+        std::vector<uint8_t> luma;
+        std::vector<uint8_t> cb;
+        std::vector<uint8_t> cr;
+        std::vector<uint8_t> filtered;
+        std::vector<uint8_t> upsampledCb;
+        std::vector<uint8_t> upsampledCr;
+    };
+
+    // Sizes the working rows for converting the MCU rows of region. Gray8 needs no chroma rows, so those are left empty
+    [[nodiscard]] auto createMcuRowScratch(const FrameInfo& frame, DecodeScale scale, Upsampling upsampling,
+                                           PixelFormat format, const Region& region) -> McuRowScratch;
+
+    /**
+     * @brief Inverse transforms, upsamples and color converts one MCU row of the dequantized coefficient planes of a
+     * YCbCr frame.
+     *
+     * Fancy upsampling also reads the chroma blocks of the MCU columns either side of the region, and of the MCU rows
+     * in planeRows.above and planeRows.below. Those are left out at the edges of the image. Gray8 reads only luma.
+     * @param scale Each block becomes 8 / scale pixels square.
+     * @param planeRows The MCU rows within the planes to convert.
+     * @param imageMcuRow Which MCU row of the image planeRows.current is.
+     * @param region The part of the scaled image to convert. Blocks outside it are not transformed.
+     * @param out Receives the pixels of the MCU row inside region in format, one row of region.width pixels every
+     * outStride bytes.
+     * @param scratch From createMcuRowScratch with the same frame, scale, upsampling, format and region.
+     */
+    auto convertMcuRowToPixels(const std::vector<CoefficientPlane>& planes, const FrameInfo& frame, DecodeScale scale,
+                               Upsampling upsampling, PixelFormat format, const PlaneRows& planeRows, size_t imageMcuRow,
+                               const Region& region, std::span<uint8_t> out, size_t outStride,
+                               McuRowScratch& scratch) -> std::expected<void, std::string>;
+
+    /**
+     * @brief Inverse transforms, upsamples and color converts the dequantized coefficient planes of a YCbCr frame into
+     * pixels of format in output, which must fit the whole scaled image.
+     *
+     * MCU rows are independent, so bands of them are converted in parallel on the shared thread pool.
+     */
+    auto convertPlanesToPixels(const std::vector<CoefficientPlane>& planes, const FrameInfo& frame, DecodeScale scale,
+                               Upsampling upsampling, PixelFormat format, const OutputBuffer& output) -> std::expected<void, std::string>;
+
+    /**
+     * @brief Inverse transforms the dequantized coefficient planes of a YCbCr frame into one plane per component,
+     * leaving chroma at its own resolution.
+     *
+     * Chroma is transformed at the same size as convertPlanesToPixels would before upsampling it. Bands of MCU
+     * rows are transformed in parallel on the shared thread pool.
+     */
+    auto convertPlanesToYCbCr(const std::vector<CoefficientPlane>& planes, const FrameInfo& frame,
+                              DecodeScale scale) -> std::expected<YCbCrImage, std::string>;
 }
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace FileParser::Jpeg {
+    /**
+     * @brief Chroma upsampling kernels, each producing one whole row of upsampled samples.
+     *
+     * The fancy kernels are the triangle filters of libjpeg: each output sample is 3/4 of its nearest input sample
+     * and 1/4 of the next nearest. They read one input sample either side of [in, in + count), so callers replicate
+     * the edge samples there at the edges of the image.
+     */
+
+    // out[2i] = out[2i + 1] = in[i]
+    auto upsampleNearest2x(const uint8_t* in, size_t count, uint8_t* out) -> void;
+
+    // Each input sample repeated factor times, for sampling factors without a dedicated kernel
+    auto upsampleNearest(const uint8_t* in, size_t count, size_t factor, uint8_t* out) -> void;
+
+    // Horizontal triangle filter, doubling the width of a row
+    auto upsampleFancy2x(const uint8_t* in, size_t count, uint8_t* out) -> void;
+
+    /**
+     * @brief Vertical triangle filter, giving one of the two output rows that lie between chroma rows.
+     * @param near The chroma row nearest to the output row.
+     * @param far The chroma row on the other side of the output row.
+     * @param upper Whether the output row is the upper of the two output rows of near, which rounds differently.
+     */
+    auto upsampleFancyVertical(const uint8_t* near, const uint8_t* far, size_t count, bool upper, uint8_t* out) -> void;
+
+    // Both triangle filters at once, doubling the width of a row. near and far are as for upsampleFancyVertical
+    auto upsampleFancy2x2(const uint8_t* near, const uint8_t* far, size_t count, uint8_t* out) -> void;
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace FileParser {
+    /**
+     * @brief A fixed set of worker threads that run queued jobs.
+     *
+     * Decoding stages that split into independent pieces (e.g. restart intervals of a scan) hand those pieces to the
+     * pool through parallelFor instead of spawning threads for every image.
+     */
+    class ThreadPool {
+        std::mutex m_mutex;
+        std::condition_variable_any m_condition;
+        std::deque<std::function<void()>> m_jobs;
+        std::vector<std::jthread> m_workers;
+
+    public:
+        explicit ThreadPool(size_t threadCount);
+        ThreadPool(const ThreadPool&) = delete;
+        ThreadPool& operator=(const ThreadPool&) = delete;
+        ThreadPool(ThreadPool&&) = delete;
+        ThreadPool& operator=(ThreadPool&&) = delete;
+        ~ThreadPool();
+
+        /**
+         * @return A process-wide pool with one worker per hardware thread, minus the calling thread.
+         */
+        static auto shared() -> ThreadPool&;
+
+        [[nodiscard]] auto getThreadCount() const -> size_t;
+
+        /**
+         * @brief Calls task(i) for every i in [0, count), spreading the calls across the pool and the calling thread.
+         *
+         * Returns once every call has finished. The calling thread takes part in the work, so calling this from inside
+         * a pool job cannot deadlock. If a task throws, the first exception is rethrown on the calling thread.
+         */
+        auto parallelFor(size_t count, const std::function<void(size_t)>& task) -> void;
+
+    private:
+        auto submit(std::function<void()> job) -> void;
+        auto workerLoop(const std::stop_token& stopToken) -> void;
+    };
+}
@@ -124,128 +124,6 @@ void PutShort(uint8_t*& bufferPos, const int value) {
     *bufferPos++ = static_cast<unsigned char>(value >> 8);
 }
 
-BitReader::BitReader(const std::vector<uint8_t>& bytes) {
-    m_bytes = bytes;
-}
-
-BitReader::BitReader(std::vector<uint8_t>&& bytes) {
-    m_bytes = std::move(bytes);
-}
-
-auto BitReader::getBit() -> uint8_t {
-    const auto result = getUInt8();
-    skipBits(1);
-    return result;
-}
-
-auto BitReader::getNBits(const size_t numBits) -> uint64_t {
-    const auto result = peekNBits(numBits);
-    skipBits(numBits);
-    return result;
-}
-
-auto BitReader::getUInt8() -> uint8_t {
-    const auto result = peekUInt8();
-    skipBits(8);
-    return result;
-}
-
-auto BitReader::getUInt16() -> uint16_t {
-    const auto result = peekUInt16();
-    skipBits(16);
-    return result;
-}
-
-auto BitReader::getUInt32() -> uint32_t {
-    const auto result = peekUInt32();
-    skipBits(32);
-    return result;
-}
-
-auto BitReader::getUInt64() -> uint64_t {
-    const auto result = peekUInt64();
-    skipBits(64);
-    return result;
-}
-
-auto BitReader::peekBit() const -> uint8_t {
-    return static_cast<uint8_t>((m_bytes[m_byteIndex] >> (7 - m_bitPosition)) & 1);
-}
-
-auto BitReader::peekNBits(const size_t numBits) const -> uint64_t {
-    if (numBits == 0) return 0;
-    if (numBits > 64) {
-        throw std::invalid_argument("Number of bits to read must be in the range [0, 64]");
-    }
-
-    uint64_t result = 0;
-    size_t bitsRead = 0;
-
-    size_t byteIndex = m_byteIndex;
-    size_t bitOffset = m_bitPosition;
-
-    while (bitsRead < numBits) {
-        constexpr size_t bitsInByte = 8;
-        const uint8_t currentByte = (byteIndex < m_bytes.size()) ? m_bytes[byteIndex] : 0;
-
-        const size_t bitsAvailable = bitsInByte - bitOffset;
-        const size_t bitsToRead = std::min(numBits - bitsRead, bitsAvailable);
-
-        const auto shifted   = static_cast<uint8_t>(currentByte >> (bitsInByte - bitOffset - bitsToRead));
-        const auto mask      = static_cast<uint8_t>((1 << bitsToRead) - 1);
-        const auto extracted = static_cast<uint8_t>(shifted & mask);
-
-        result = (result << bitsToRead) | extracted;
-
-        bitsRead += bitsToRead;
-        bitOffset += bitsToRead;
-
-        if (bitOffset == bitsInByte) {
-            bitOffset = 0;
-            ++byteIndex;
-        }
-    }
-
-    return result;
-}
-
-auto BitReader::peekUInt8() const -> uint8_t {
-    return static_cast<uint8_t>(peekNBits(8));
-}
-
-auto BitReader::peekUInt16() const -> uint16_t {
-    return static_cast<uint16_t>(peekNBits(16));
-}
-
-auto BitReader::peekUInt32() const -> uint32_t {
-    return static_cast<uint32_t>(peekNBits(32));
-}
-
-auto BitReader::peekUInt64() const -> uint64_t {
-    return peekNBits(64);
-}
-
-auto BitReader::skipBits(const size_t numBits) -> void {
-    constexpr size_t bitsInByte = 8;
-    m_bitPosition += numBits;
-    m_byteIndex   += m_bitPosition / bitsInByte;
-    m_bitPosition  = m_bitPosition % bitsInByte;
-}
-
-auto BitReader::alignToByte() -> void {
-    if (m_bitPosition == 0) return;
-    m_bitPosition = 0;
-    m_byteIndex++;
-}
-
-auto BitReader::reachedEnd() const -> bool {
-    return m_byteIndex >= m_bytes.size();
-}
-
-auto BitReader::addByte(const uint8_t byte) -> void {
-    m_bytes.push_back(byte);
-}
-
 BitWriter::BitWriter(const std::string& filepath, size_t bufferSize) : m_bufferSize(bufferSize), m_buffer(bufferSize), m_filepath(filepath) {
     m_file = std::ofstream(m_filepath, std::ios::out | std::ios::binary);
     if (!m_file.is_open()) {
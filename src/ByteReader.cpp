@@ -1,5 +1,6 @@
 #include "FileParser/ByteReader.hpp"
 
+#include <algorithm>
 #include <cstring>
 #include <fstream>
 
@@ -44,6 +45,10 @@ auto FileParser::IO::ByteSpanReader::has_failed() const -> bool {
     return m_failed;
 }
 
+auto FileParser::IO::ByteSpanReader::remaining_bytes() const -> std::span<const uint8_t> {
+    return m_bytes.subspan(std::min(m_pos, m_bytes.size()));
+}
+
 auto FileParser::IO::ByteSpanReader::read_into(uint8_t *buffer, const size_t len) -> void {
     if (const size_t remaining = m_bytes.size() - m_pos; len > remaining) {
         m_failed = true;
@@ -1,5 +1,6 @@
 ﻿#include "FileParser/Cli.h"
 
+#include <charconv>
 #include <filesystem>
 #include <functional>
 #include <iostream>
@@ -126,6 +127,45 @@ static void Convert(const std::vector<std::string>& args) {
     }
 }
 
+/**
+ * @brief Checks that speculatively decoding a Jpeg scan without restart markers matches decoding it serially.
+ * @param args A vector of the input arguments.
+ *  - args[0] is the name of the command "speculate".
+ *  - args[1] is the filepath to the Jpeg file.
+ *  - args[2] is the number of chunks to split the scan into (default: 8)
+ */
+static void Speculate(const std::vector<std::string>& args) {
+    using namespace FileUtils;
+    using namespace FileParser;
+
+    if (args.size() != 2 && args.size() != 3) {
+        std::cerr << "Usage: speculate <filename> [<chunk count>] (default: 8)\n";
+        return;
+    }
+
+    const std::string& filepath = args[1];
+    size_t chunkCount = 8;
+    if (args.size() == 3) {
+        const std::string& countStr = args[2];
+        const auto [end, error] = std::from_chars(countStr.data(), countStr.data() + countStr.size(), chunkCount);
+        if (error != std::errc{} || end != countStr.data() + countStr.size()) {
+            std::cerr << "Error: Invalid chunk count: " << countStr << '\n';
+            return;
+        }
+    }
+
+    const auto bytes = readFileBytes(filepath);
+    if (!bytes) {
+        std::cerr << "Error: Failed to read file: " << filepath << ": " << bytes.error() << '\n';
+        return;
+    }
+    if (const auto result = Jpeg::Decoder::checkSpeculativeDecode(*bytes, chunkCount); !result) {
+        std::cerr << "Error: " << filepath << ": " << result.error() << '\n';
+        return;
+    }
+    std::cout << "Speculative and serial decoding match: " << filepath << '\n';
+}
+
 static void Test(const std::vector<std::string>& args) {
     using namespace FileParser;
     using namespace Jpeg;
@@ -141,6 +181,7 @@ static void Test(const std::vector<std::string>& args) {
 static std::unordered_map<std::string, std::function<void(const std::vector<std::string>&)>> commands = {
     {"render", Render},
     {"convert", Convert},
+    {"speculate", Speculate},
     {"test", Test}
 };
 
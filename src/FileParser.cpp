@@ -78,18 +78,20 @@ GLuint compileShaders(const char* vertSrc, const char* fragSrc) {
 
 auto decodeImage(const std::filesystem::path& filePath) -> std::expected<FileParser::Image, std::string> {
     using namespace FileUtils;
-    const FileType fileType = getFileType(filePath.string());
+    // Read the file once and decode from memory, instead of opening it again for each step
+    ASSIGN_OR_PROPAGATE(bytes, readFileBytes(filePath));
+    const FileType fileType = getFileType(std::span<const uint8_t>(bytes));
     switch (fileType) {
         case FileType::Bmp: {
-            FileParser::IO::ByteStream reader{filePath};
-            const auto img = FileParser::Bmp::decode(reader.reader);
+            auto reader = FileParser::IO::ByteSpanReader::from_bytes(std::span<const uint8_t>(bytes));
+            const auto img = FileParser::Bmp::decode(reader);
             if (!img) {
                 return FileParser::utils::getUnexpected(img, "Unable to parse bmp");
             }
             return img;
         }
         case FileType::Jpeg: {
-            const auto img = FileParser::Jpeg::Decoder::decode(filePath);
+            const auto img = FileParser::Jpeg::Decoder::decode(std::span<const uint8_t>(bytes));
             if (!img) {
                 return FileParser::utils::getUnexpected(img, "Unable to parse jpeg");
             }
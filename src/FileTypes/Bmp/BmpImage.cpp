@@ -247,6 +247,18 @@ auto FileParser::Bmp::parseImageData24Bit(
     return rgbData;
 }
 
+auto FileParser::Bmp::probe(IO::ByteSpanReader& reader) -> std::expected<ProbeInfo, std::string> {
+    ASSIGN_OR_RETURN(header, parseHeader(reader), "Unable to parse header");
+    ASSIGN_OR_RETURN(info,   parseInfo(reader),   "Unable to parse info");
+    return ProbeInfo { .header = header, .info = info };
+}
+
+auto FileParser::Bmp::probe(const std::filesystem::path& filePath) -> std::expected<ProbeInfo, std::string> {
+    ASSIGN_OR_PROPAGATE(bytes, FileUtils::readFilePrefix(filePath, probeBytes));
+    auto reader = IO::ByteSpanReader::from_bytes(std::span<const uint8_t>(bytes));
+    return probe(reader);
+}
+
 auto FileParser::Bmp::decode(IO::ByteSpanReader& reader) -> std::expected<Image, std::string> {
     BmpData bmpData;
 
@@ -3,6 +3,9 @@
 #include "FileParser/Macros.hpp"
 
 auto FileParser::Bmp::encode(const Image& image, const std::filesystem::path& savePath) -> std::expected<void, std::string> {
+    if (image.format != PixelFormat::RGB) {
+        return std::unexpected("Only RGB images can be encoded as Bmp");
+    }
     ASSIGN_OR_PROPAGATE_MUT(file, FileUtils::openRegularFileForWrite(savePath, std::ios::binary));
     FileUtils::writeSignatureToFile(file, FileUtils::bmpSig);
 
@@ -0,0 +1,47 @@
+#include "FileParser/Jpeg/BitReader.hpp"
+
+#include <algorithm>
+
+FileParser::Jpeg::BitReader::BitReader(const std::span<const uint8_t> bytes)
+    : BitReader(bytes, 0, 0) {}
+
+FileParser::Jpeg::BitReader::BitReader(const std::span<const uint8_t> bytes, const size_t startByte, const size_t startBitPosition)
+    : m_bytes(bytes), m_nextByte(startByte), m_loadedBytes(startBitPosition / bitsInByte) {
+    refill();
+    skipBits(startBitPosition % bitsInByte);
+}
+
+// Loads one byte at a time, unstuffing 0xFF00 and stopping at markers
+auto FileParser::Jpeg::BitReader::refillSlow() -> void {
+    while (m_bitCount < 56) {
+        uint8_t byte = 0;
+        if (m_nextByte < m_bytes.size()) {
+            byte = m_bytes[m_nextByte];
+            if (byte != MarkerHeader) {
+                m_nextByte++;
+            } else if (m_nextByte + 1 < m_bytes.size() && m_bytes[m_nextByte + 1] == ByteStuffing) {
+                m_nextByte += 2;
+            } else {
+                byte = 0;
+                m_endBitPosition = std::min(m_endBitPosition, m_loadedBytes * bitsInByte);
+            }
+        } else {
+            m_endBitPosition = std::min(m_endBitPosition, m_loadedBytes * bitsInByte);
+        }
+        m_accumulator |= static_cast<uint64_t>(byte) << (56 - m_bitCount);
+        m_bitCount    += bitsInByte;
+        m_loadedBytes++;
+    }
+}
+
+auto FileParser::Jpeg::BitReader::alignToByte() -> void {
+    skipBits(m_bitCount % bitsInByte);
+}
+
+auto FileParser::Jpeg::BitReader::reachedEnd() const -> bool {
+    return getBitPosition() >= m_endBitPosition;
+}
+
+auto FileParser::Jpeg::BitReader::getBitPosition() const -> size_t {
+    return m_loadedBytes * bitsInByte - m_bitCount;
+}
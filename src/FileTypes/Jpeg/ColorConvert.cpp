@@ -0,0 +1,263 @@
+#include "FileParser/Jpeg/ColorConvert.hpp"
+
+#include <algorithm>
+
+#include <simde/x86/sse2.h>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+    #define HAS_AVX2_KERNEL
+    #include <immintrin.h>
+    #if defined(_MSC_VER) && !defined(__clang__)
+        #include <intrin.h>
+        #define AVX2_TARGET
+    #else
+        #define AVX2_TARGET __attribute__((target("avx2")))
+    #endif
+#endif
+
+namespace {
+    using FileParser::PixelFormat;
+
+    // The JFIF factors scaled by 2^14. 1.772 is the largest, and 14 bits is as far as it can be scaled within an int16
+    constexpr int fractionBits = 14;
+    constexpr int32_t crToR =  22970; //  1.402
+    constexpr int32_t cbToG = -5638;  // -0.344136
+    constexpr int32_t crToG = -11700; // -0.714136
+    constexpr int32_t cbToB =  29032; //  1.772
+    constexpr int32_t rounding = 1 << (fractionBits - 1);
+
+    // A pair of factors for multiplying interleaved (Cb, Cr) samples with madd
+    constexpr auto pairFactors(const int32_t cbFactor, const int32_t crFactor) -> int32_t {
+        return static_cast<int32_t>(static_cast<uint32_t>(crFactor) << 16 | (static_cast<uint32_t>(cbFactor) & 0xFFFF));
+    }
+
+    template <PixelFormat Format>
+    constexpr bool isBgrOrder = Format == PixelFormat::BGR || Format == PixelFormat::BGRA;
+
+    template <PixelFormat Format>
+    auto convertPixel(const uint8_t y, const uint8_t cb, const uint8_t cr, uint8_t* out) -> void {
+        const int32_t blue = cb - 128;
+        const int32_t red  = cr - 128;
+        const auto saturate = [](const int32_t value) { return static_cast<uint8_t>(std::clamp(value, 0, 255)); };
+        const uint8_t r = saturate(y + ((crToR * red + rounding) >> fractionBits));
+        const uint8_t g = saturate(y + ((cbToG * blue + crToG * red + rounding) >> fractionBits));
+        const uint8_t b = saturate(y + ((cbToB * blue + rounding) >> fractionBits));
+        out[0] = isBgrOrder<Format> ? b : r;
+        out[1] = g;
+        out[2] = isBgrOrder<Format> ? r : b;
+        if constexpr (getBytesPerPixel(Format) == 4) {
+            out[3] = 0xFF;
+        }
+    }
+
+    // SSE2
+
+    struct PixelsSse2 { simde__m128i low, high; }; // Pixels 0-3 and 4-7, four bytes each
+
+    // One channel of eight pixels: y plus the rounded chroma term, saturated to [0, 255]
+    auto channelSse2(const simde__m128i y, const simde__m128i lowPairs, const simde__m128i highPairs, const int32_t factors) -> simde__m128i {
+        const simde__m128i factorVector = simde_mm_set1_epi32(factors);
+        const simde__m128i roundingVector = simde_mm_set1_epi32(rounding);
+        const simde__m128i low  = simde_mm_srai_epi32(simde_mm_add_epi32(simde_mm_madd_epi16(lowPairs,  factorVector), roundingVector), fractionBits);
+        const simde__m128i high = simde_mm_srai_epi32(simde_mm_add_epi32(simde_mm_madd_epi16(highPairs, factorVector), roundingVector), fractionBits);
+        const simde__m128i channel = simde_mm_add_epi16(y, simde_mm_packs_epi32(low, high));
+        return simde_mm_min_epi16(simde_mm_max_epi16(channel, simde_mm_setzero_si128()), simde_mm_set1_epi16(255));
+    }
+
+    // Eight pixels from samples widened to 16 bits, with the fourth byte of each the alpha or padding
+    template <PixelFormat Format>
+    auto convertSse2(const simde__m128i y, simde__m128i cb, simde__m128i cr) -> PixelsSse2 {
+        const simde__m128i center = simde_mm_set1_epi16(128);
+        cb = simde_mm_sub_epi16(cb, center);
+        cr = simde_mm_sub_epi16(cr, center);
+        const simde__m128i lowPairs  = simde_mm_unpacklo_epi16(cb, cr);
+        const simde__m128i highPairs = simde_mm_unpackhi_epi16(cb, cr);
+        const simde__m128i r = channelSse2(y, lowPairs, highPairs, pairFactors(0, crToR));
+        const simde__m128i g = channelSse2(y, lowPairs, highPairs, pairFactors(cbToG, crToG));
+        const simde__m128i b = channelSse2(y, lowPairs, highPairs, pairFactors(cbToB, 0));
+        const simde__m128i alpha = getBytesPerPixel(Format) == 4 ? simde_mm_set1_epi16(static_cast<int16_t>(0xFF00)) : simde_mm_setzero_si128();
+        const simde__m128i firstTwo = simde_mm_or_si128(isBgrOrder<Format> ? b : r, simde_mm_slli_epi16(g, 8));
+        const simde__m128i lastTwo  = simde_mm_or_si128(isBgrOrder<Format> ? r : b, alpha);
+        return { simde_mm_unpacklo_epi16(firstTwo, lastTwo), simde_mm_unpackhi_epi16(firstTwo, lastTwo) };
+    }
+
+    // Drops the padding byte of four RGBX pixels, leaving 12 bytes of RGB at the bottom
+    auto dropPaddingSse2(const simde__m128i pixels) -> simde__m128i {
+        // Each 64-bit half becomes six bytes: its first pixel, then its second moved down over the padding
+        const simde__m128i halves = simde_mm_or_si128(
+            simde_mm_and_si128(pixels, simde_mm_set1_epi64x(0x0000'0000'00FF'FFFF)),
+            simde_mm_and_si128(simde_mm_srli_epi64(pixels, 8), simde_mm_set1_epi64x(0x0000'FFFF'FF00'0000)));
+        return simde_mm_or_si128(
+            simde_mm_and_si128(halves, simde_mm_set_epi64x(0, 0x0000'FFFF'FFFF'FFFF)),
+            simde_mm_and_si128(simde_mm_srli_si128(halves, 2), simde_mm_set_epi64x(0x0000'0000'FFFF'FFFF, static_cast<int64_t>(0xFFFF'0000'0000'0000))));
+    }
+
+    // Stores sixteen pixels. Three byte pixels lose their padding, and each store overruns into the next except the
+    // last, which stores exactly 12 bytes
+    template <PixelFormat Format>
+    auto storeSse2(uint8_t* out, const PixelsSse2& first, const PixelsSse2& second) -> void {
+        if constexpr (getBytesPerPixel(Format) == 4) {
+            simde_mm_storeu_si128(reinterpret_cast<simde__m128i*>(out),      first.low);
+            simde_mm_storeu_si128(reinterpret_cast<simde__m128i*>(out + 16), first.high);
+            simde_mm_storeu_si128(reinterpret_cast<simde__m128i*>(out + 32), second.low);
+            simde_mm_storeu_si128(reinterpret_cast<simde__m128i*>(out + 48), second.high);
+            return;
+        }
+        simde_mm_storeu_si128(reinterpret_cast<simde__m128i*>(out),      dropPaddingSse2(first.low));
+        simde_mm_storeu_si128(reinterpret_cast<simde__m128i*>(out + 12), dropPaddingSse2(first.high));
+        simde_mm_storeu_si128(reinterpret_cast<simde__m128i*>(out + 24), dropPaddingSse2(second.low));
+        const simde__m128i last = dropPaddingSse2(second.high);
+        simde_mm_storel_epi64(reinterpret_cast<simde__m128i*>(out + 36), last);
+        const int32_t lastBytes = simde_mm_cvtsi128_si32(simde_mm_srli_si128(last, 8));
+        std::copy_n(reinterpret_cast<const uint8_t*>(&lastBytes), sizeof(lastBytes), out + 44);
+    }
+
+    template <PixelFormat Format>
+    auto convertRowSse2(const uint8_t* y, const uint8_t* cb, const uint8_t* cr, const size_t count, uint8_t* out) -> size_t {
+        constexpr size_t pixelsPerIteration = 16;
+        const simde__m128i zero = simde_mm_setzero_si128();
+        size_t i = 0;
+        for (; i + pixelsPerIteration <= count; i += pixelsPerIteration) {
+            const simde__m128i ys  = simde_mm_loadu_si128(reinterpret_cast<const simde__m128i*>(y + i));
+            const simde__m128i cbs = simde_mm_loadu_si128(reinterpret_cast<const simde__m128i*>(cb + i));
+            const simde__m128i crs = simde_mm_loadu_si128(reinterpret_cast<const simde__m128i*>(cr + i));
+            const PixelsSse2 first  = convertSse2<Format>(simde_mm_unpacklo_epi8(ys, zero), simde_mm_unpacklo_epi8(cbs, zero), simde_mm_unpacklo_epi8(crs, zero));
+            const PixelsSse2 second = convertSse2<Format>(simde_mm_unpackhi_epi8(ys, zero), simde_mm_unpackhi_epi8(cbs, zero), simde_mm_unpackhi_epi8(crs, zero));
+            storeSse2<Format>(out + getBytesPerPixel(Format) * i, first, second);
+        }
+        return i;
+    }
+
+#ifdef HAS_AVX2_KERNEL
+    // AVX2, the same steps on sixteen pixels at a time. Only called once the processor is known to support it
+
+    struct PixelsAvx2 { __m256i low, high; }; // Pixels 0-3 and 8-11, and 4-7 and 12-15, four bytes each
+
+    AVX2_TARGET auto channelAvx2(const __m256i y, const __m256i lowPairs, const __m256i highPairs, const int32_t factors) -> __m256i {
+        const __m256i factorVector = _mm256_set1_epi32(factors);
+        const __m256i roundingVector = _mm256_set1_epi32(rounding);
+        const __m256i low  = _mm256_srai_epi32(_mm256_add_epi32(_mm256_madd_epi16(lowPairs,  factorVector), roundingVector), fractionBits);
+        const __m256i high = _mm256_srai_epi32(_mm256_add_epi32(_mm256_madd_epi16(highPairs, factorVector), roundingVector), fractionBits);
+        const __m256i channel = _mm256_add_epi16(y, _mm256_packs_epi32(low, high));
+        return _mm256_min_epi16(_mm256_max_epi16(channel, _mm256_setzero_si256()), _mm256_set1_epi16(255));
+    }
+
+    template <PixelFormat Format>
+    AVX2_TARGET auto convertAvx2(const uint8_t* y, const uint8_t* cb, const uint8_t* cr) -> PixelsAvx2 {
+        const __m256i center = _mm256_set1_epi16(128);
+        const __m256i ys  = _mm256_cvtepu8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(y)));
+        const __m256i cbs = _mm256_sub_epi16(_mm256_cvtepu8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(cb))), center);
+        const __m256i crs = _mm256_sub_epi16(_mm256_cvtepu8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(cr))), center);
+        const __m256i lowPairs  = _mm256_unpacklo_epi16(cbs, crs);
+        const __m256i highPairs = _mm256_unpackhi_epi16(cbs, crs);
+        const __m256i r = channelAvx2(ys, lowPairs, highPairs, pairFactors(0, crToR));
+        const __m256i g = channelAvx2(ys, lowPairs, highPairs, pairFactors(cbToG, crToG));
+        const __m256i b = channelAvx2(ys, lowPairs, highPairs, pairFactors(cbToB, 0));
+        const __m256i alpha = getBytesPerPixel(Format) == 4 ? _mm256_set1_epi16(static_cast<int16_t>(0xFF00)) : _mm256_setzero_si256();
+        const __m256i firstTwo = _mm256_or_si256(isBgrOrder<Format> ? b : r, _mm256_slli_epi16(g, 8));
+        const __m256i lastTwo  = _mm256_or_si256(isBgrOrder<Format> ? r : b, alpha);
+        return { _mm256_unpacklo_epi16(firstTwo, lastTwo), _mm256_unpackhi_epi16(firstTwo, lastTwo) };
+    }
+
+    AVX2_TARGET auto dropPaddingAvx2(const __m256i pixels) -> __m256i {
+        const __m256i halves = _mm256_or_si256(
+            _mm256_and_si256(pixels, _mm256_set1_epi64x(0x0000'0000'00FF'FFFF)),
+            _mm256_and_si256(_mm256_srli_epi64(pixels, 8), _mm256_set1_epi64x(0x0000'FFFF'FF00'0000)));
+        const __m256i keepLow  = _mm256_set_epi64x(0, 0x0000'FFFF'FFFF'FFFF, 0, 0x0000'FFFF'FFFF'FFFF);
+        const __m256i keepHigh = _mm256_set_epi64x(0x0000'0000'FFFF'FFFF, static_cast<int64_t>(0xFFFF'0000'0000'0000),
+                                                   0x0000'0000'FFFF'FFFF, static_cast<int64_t>(0xFFFF'0000'0000'0000));
+        return _mm256_or_si256(_mm256_and_si256(halves, keepLow), _mm256_and_si256(_mm256_srli_si256(halves, 2), keepHigh));
+    }
+
+    // Stores 32 pixels, in the same way as storeSse2
+    template <PixelFormat Format>
+    AVX2_TARGET auto storeAvx2(uint8_t* out, const PixelsAvx2& first, const PixelsAvx2& second) -> void {
+        if constexpr (getBytesPerPixel(Format) == 4) {
+            // The 128-bit lanes of each half hold pixels that are eight apart, so pair up the lanes of the halves
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(out),      _mm256_permute2x128_si256(first.low,  first.high,  0x20));
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + 32), _mm256_permute2x128_si256(first.low,  first.high,  0x31));
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + 64), _mm256_permute2x128_si256(second.low, second.high, 0x20));
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + 96), _mm256_permute2x128_si256(second.low, second.high, 0x31));
+            return;
+        }
+        const __m256i chunks[4] = {
+            dropPaddingAvx2(first.low), dropPaddingAvx2(first.high), dropPaddingAvx2(second.low), dropPaddingAvx2(second.high)
+        };
+        // The 128-bit lanes of each chunk hold pixels that are eight apart
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out),      _mm256_castsi256_si128(chunks[0]));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + 12), _mm256_castsi256_si128(chunks[1]));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + 24), _mm256_extracti128_si256(chunks[0], 1));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + 36), _mm256_extracti128_si256(chunks[1], 1));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + 48), _mm256_castsi256_si128(chunks[2]));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + 60), _mm256_castsi256_si128(chunks[3]));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + 72), _mm256_extracti128_si256(chunks[2], 1));
+        const __m128i last = _mm256_extracti128_si256(chunks[3], 1);
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(out + 84), last);
+        const int32_t lastBytes = _mm_cvtsi128_si32(_mm_srli_si128(last, 8));
+        std::copy_n(reinterpret_cast<const uint8_t*>(&lastBytes), sizeof(lastBytes), out + 92);
+    }
+
+    template <PixelFormat Format>
+    AVX2_TARGET auto convertRowAvx2(const uint8_t* y, const uint8_t* cb, const uint8_t* cr, const size_t count, uint8_t* out) -> size_t {
+        constexpr size_t pixelsPerIteration = 32;
+        size_t i = 0;
+        for (; i + pixelsPerIteration <= count; i += pixelsPerIteration) {
+            const PixelsAvx2 first  = convertAvx2<Format>(y + i,      cb + i,      cr + i);
+            const PixelsAvx2 second = convertAvx2<Format>(y + i + 16, cb + i + 16, cr + i + 16);
+            storeAvx2<Format>(out + getBytesPerPixel(Format) * i, first, second);
+        }
+        return i;
+    }
+
+    auto hasAvx2() -> bool {
+    #if defined(_MSC_VER) && !defined(__clang__)
+        // AVX2 also needs the operating system to save the upper halves of the registers
+        int info[4];
+        __cpuid(info, 1);
+        const bool osSavesAvx = (info[2] & (1 << 27)) != 0 && (info[2] & (1 << 28)) != 0 && (_xgetbv(0) & 0x6) == 0x6;
+        __cpuidex(info, 7, 0);
+        return osSavesAvx && (info[1] & (1 << 5)) != 0;
+    #else
+        return __builtin_cpu_supports("avx2");
+    #endif
+    }
+#endif
+
+    // Converts as many pixels as the kernel handles in whole iterations and returns how many that was
+    using RowKernel = size_t (*)(const uint8_t* y, const uint8_t* cb, const uint8_t* cr, size_t count, uint8_t* out);
+
+    template <PixelFormat Format>
+    auto selectRowKernel() -> RowKernel {
+    #ifdef HAS_AVX2_KERNEL
+        static const bool avx2 = hasAvx2();
+        if (avx2) {
+            return convertRowAvx2<Format>;
+        }
+    #endif
+        return convertRowSse2<Format>;
+    }
+
+    template <PixelFormat Format>
+    auto convertRow(const uint8_t* y, const uint8_t* cb, const uint8_t* cr, const size_t count, uint8_t* out) -> void {
+        static const RowKernel kernel = selectRowKernel<Format>();
+        constexpr size_t bytesPerPixel = getBytesPerPixel(Format);
+        size_t i = kernel(y, cb, cr, count, out);
+        // The SSE2 kernel also picks up what is left after AVX2 iterations
+        i += convertRowSse2<Format>(y + i, cb + i, cr + i, count - i, out + bytesPerPixel * i);
+        for (; i < count; i++) {
+            convertPixel<Format>(y[i], cb[i], cr[i], out + bytesPerPixel * i);
+        }
+    }
+}
+
+auto FileParser::Jpeg::convertYCbCrRow(
+    const uint8_t* y, const uint8_t* cb, const uint8_t* cr, const size_t count, const PixelFormat format, uint8_t* out
+) -> void {
+    switch (format) {
+        case PixelFormat::RGB:   convertRow<PixelFormat::RGB>(y, cb, cr, count, out);  break;
+        case PixelFormat::BGR:   convertRow<PixelFormat::BGR>(y, cb, cr, count, out);  break;
+        case PixelFormat::RGBA:  convertRow<PixelFormat::RGBA>(y, cb, cr, count, out); break;
+        case PixelFormat::BGRA:  convertRow<PixelFormat::BGRA>(y, cb, cr, count, out); break;
+        case PixelFormat::Gray8: std::copy_n(y, count, out); break;
+    }
+}
@@ -2,20 +2,23 @@
 
 #include <algorithm>
 #include <format>
-#include <fstream>
-#include <iostream>
+#include <limits>
+#include <optional>
+#include <ranges>
 #include <unordered_set>
 
 #include "FileParser/BitManipulationUtil.h"
 #include "FileParser/FileUtil.h"
 #include "FileParser/Image.hpp"
 #include "FileParser/Jpeg/HuffmanBuilder.hpp"
+#include "FileParser/Jpeg/MarkerScanner.hpp"
 #include "FileParser/Jpeg/Markers.hpp"
 #include "FileParser/Jpeg/Transform.hpp"
 #include "FileParser/Macros.hpp"
+#include "FileParser/ThreadPool.hpp"
 #include "FileParser/Utils.hpp"
 
-#define READ_LENGTH() ASSIGN_OR_RETURN(length, read_uint16_be(file), "Unable to read length");
+#define READ_LENGTH() BYTEREADER_READ_OR_RETURN(const, length, reader, read_be<uint16_t>(), std::unexpected("Unable to read length"))
 
 #define REQUIRE_LENGTH(actual, expected) \
     if ((actual) != (expected)) { \
@@ -28,11 +31,11 @@
 
 
 auto FileParser::Jpeg::Parser::parseFrameComponent(
-    std::ifstream& file
+    IO::ByteSpanReader& reader
 ) -> std::expected<FrameComponent, std::string> {
-    ASSIGN_OR_RETURN(identifier,     read_uint8(file), "Unable to read component identifier");
-    ASSIGN_OR_RETURN(samplingFactor, read_uint8(file), "Unable to read sampling factor");
-    ASSIGN_OR_RETURN(qTableSelector, read_uint8(file), "Unable to read quantization table selector");
+    BYTEREADER_READ_OR_RETURN(const, identifier,     reader, read_u8(), std::unexpected("Unable to read component identifier"));
+    BYTEREADER_READ_OR_RETURN(const, samplingFactor, reader, read_u8(), std::unexpected("Unable to read sampling factor"));
+    BYTEREADER_READ_OR_RETURN(const, qTableSelector, reader, read_u8(), std::unexpected("Unable to read quantization table selector"));
 
     FrameComponent component {
         .identifier                = identifier,
@@ -60,23 +63,19 @@ auto FileParser::Jpeg::Parser::parseFrameComponent(
     return component;
 }
 
-auto FileParser::Jpeg::Parser::parseFrameHeader(std::ifstream& file, const uint8_t SOF) -> std::expected<FrameHeader, std::string> {
-    if (SOF != SOF0) {
-        return std::unexpected(std::format(R"(Unsupported start of frame marker: "{}")", SOF));
-    }
-
+auto FileParser::Jpeg::Parser::parseFrameHeader(IO::ByteSpanReader& reader) -> std::expected<FrameHeader, std::string> {
     FrameHeader frame;
     READ_LENGTH();
-    ASSIGN_OR_RETURN(precision, read_uint8(file), "Unable to read frame precision");
+    BYTEREADER_READ_OR_RETURN(const, precision, reader, read_u8(), std::unexpected("Unable to read frame precision"));
     frame.precision = precision;
     if (frame.precision != 8) {
         return std::unexpected(
             std::format("Unsupported precision in frame header: {}, precision must be 8 bits", frame.precision));
     }
 
-    ASSIGN_OR_RETURN(numberOfLines,          read_uint16_be(file), "Unable to read number of lines");
-    ASSIGN_OR_RETURN(numberOfSamplesPerLine, read_uint16_be(file), "Unable to read number of samples per line");
-    ASSIGN_OR_RETURN(numberOfComponents,     read_uint8(file),     "Unable to read number of components");
+    BYTEREADER_READ_OR_RETURN(const, numberOfLines,          reader, read_be<uint16_t>(), std::unexpected("Unable to read number of lines"));
+    BYTEREADER_READ_OR_RETURN(const, numberOfSamplesPerLine, reader, read_be<uint16_t>(), std::unexpected("Unable to read number of samples per line"));
+    BYTEREADER_READ_OR_RETURN(const, numberOfComponents,     reader, read_u8(),           std::unexpected("Unable to read number of components"));
     frame.numberOfLines          = numberOfLines;
     frame.numberOfSamplesPerLine = numberOfSamplesPerLine;
 
@@ -90,7 +89,7 @@ auto FileParser::Jpeg::Parser::parseFrameHeader(std::ifstream& file, const uint8
     }
 
     for (size_t i = 0; i < numberOfComponents; ++i) {
-        auto component = parseFrameComponent(file);
+        auto component = parseFrameComponent(reader);
         if (!component) {
             return std::unexpected(std::format("Error parsing frame component #{}: {}", i, component.error()));
         }
@@ -101,69 +100,69 @@ auto FileParser::Jpeg::Parser::parseFrameHeader(std::ifstream& file, const uint8
 }
 
 auto FileParser::Jpeg::Parser::parseDNL(
-    std::ifstream& file
+    IO::ByteSpanReader& reader
 ) -> std::expected<uint16_t, std::string> {
     READ_AND_REQUIRE_LENGTH(4);
-    ASSIGN_OR_RETURN(numberOfLines, read_uint16_be(file), "Unable to read number of lines");
+    BYTEREADER_READ_OR_RETURN(const, numberOfLines, reader, read_be<uint16_t>(), std::unexpected("Unable to read number of lines"));
     return numberOfLines;
 }
 
 auto FileParser::Jpeg::Parser::parseDRI(
-    std::ifstream& file
+    IO::ByteSpanReader& reader
 ) -> std::expected<uint16_t, std::string> {
     READ_AND_REQUIRE_LENGTH(4);
-    ASSIGN_OR_RETURN(restartInterval, read_uint16_be(file), "Unable to read restart interval");
+    BYTEREADER_READ_OR_RETURN(const, restartInterval, reader, read_be<uint16_t>(), std::unexpected("Unable to read restart interval"));
     return restartInterval;
 }
 
-auto FileParser::Jpeg::Parser::parseComment(std::ifstream& file) -> std::expected<std::string, std::string> {
+auto FileParser::Jpeg::Parser::parseComment(IO::ByteSpanReader& reader) -> std::expected<std::string, std::string> {
     READ_LENGTH();
-    ASSIGN_OR_RETURN(comment, read_string(file, length - 2), "Unable to read comment");
+    if (length < 2) {
+        return std::unexpected(std::format("Comment length must be at least 2, got {}", length));
+    }
+    std::string comment(length - 2u, '\0');
+    BYTEREADER_CALL_VOID_OR_RETURN(reader, read_into(reinterpret_cast<uint8_t *>(comment.data()), comment.size()),
+        std::unexpected("Unable to read comment"));
     return comment;
 }
 
 auto FileParser::Jpeg::Parser::parseDQT(
-    std::ifstream& file
+    IO::ByteSpanReader& reader
 ) -> std::expected<std::vector<QuantizationTable>, std::string> {
-    const std::streampos filePosBefore = file.tellg();
+    const size_t posBefore = reader.get_pos();
     READ_LENGTH();
 
     std::vector<QuantizationTable> tables;
-    while (file.tellg() - filePosBefore < length && file) {
-        ASSIGN_OR_RETURN(precisionAndDestination, read_uint8(file), "Unable to read precision and id");
+    while (reader.get_pos() - posBefore < length) {
+        BYTEREADER_READ_OR_RETURN(const, precisionAndDestination, reader, read_u8(), std::unexpected("Unable to read precision and id"));
 
         QuantizationTable& table = tables.emplace_back();
         // Precision (1 = 16-bit, 0 = 8-bit) in upper nibble, Destination ID in lower nibble
         table.precision   = getUpperNibble(precisionAndDestination);
         table.destination = getLowerNibble(precisionAndDestination);
 
-        if (table.precision == 0) {
-            ASSIGN_OR_RETURN(elements, read_uint8(file, QuantizationTable::length), "Unable to read quantization table elements");
-            for (size_t i = 0; i < QuantizationTable::length; i++) {
-                table[zigZagMap[i]] = static_cast<float>((elements)[i]);
-            }
-        } else {
-            ASSIGN_OR_RETURN(elements, read_uint16_be(file, QuantizationTable::length), "Unable to read quantization table elements");
-            for (size_t i = 0; i < QuantizationTable::length; i++) {
-                table[zigZagMap[i]] = static_cast<float>((elements)[i]);
+        for (size_t i = 0; i < QuantizationTable::length; i++) {
+            const uint16_t element = table.precision == 0 ? reader.read_u8() : reader.read_be<uint16_t>();
+            if (reader.has_failed()) {
+                return std::unexpected("Unable to read quantization table elements");
             }
+            table[zigZagMap[i]] = static_cast<float>(element);
         }
     }
-    const std::streampos filePosAfter = file.tellg();
-    if (const auto bytesRead = filePosAfter - filePosBefore; bytesRead != length) {
+    if (const auto bytesRead = reader.get_pos() - posBefore; bytesRead != length) {
         return std::unexpected(std::format("Length mismatch. Length was {}, however {} bytes was read", length, bytesRead));
     }
     return tables;
 }
 
 auto FileParser::Jpeg::Parser::parseDHT(
-    std::ifstream& file
+    IO::ByteSpanReader& reader
 ) -> std::expected<std::vector<HuffmanParseResult>, std::string> {
-    const std::streampos filePosBefore = file.tellg();
-    READ_LENGTH()
+    const size_t posBefore = reader.get_pos();
+    READ_LENGTH();
     std::vector<HuffmanParseResult> tables;
-    while (file.tellg() - filePosBefore < length && file) {
-        ASSIGN_OR_RETURN(tableClassAndDestination, read_uint8(file), "Unable to parse table class and destination");
+    while (reader.get_pos() - posBefore < length) {
+        BYTEREADER_READ_OR_RETURN(const, tableClassAndDestination, reader, read_u8(), std::unexpected("Unable to parse table class and destination"));
         auto& [tableClass, tableDestination, table] = tables.emplace_back();
         tableClass       = getUpperNibble(tableClassAndDestination);
         tableDestination = getLowerNibble(tableClassAndDestination);
@@ -176,21 +175,20 @@ auto FileParser::Jpeg::Parser::parseDHT(
             return std::unexpected(std::format("Table destination must be between 0 and 3, got {}", tableDestination));
         }
 
-        ASSIGN_OR_RETURN_MUT(constructedTable, HuffmanBuilder::readFromFile(file), "Unable to parse Huffman table");
+        ASSIGN_OR_RETURN_MUT(constructedTable, HuffmanBuilder::readFromBytes(reader), "Unable to parse Huffman table");
         table = std::move(constructedTable);
     }
-    const std::streampos filePosAfter = file.tellg();
-    if (const auto bytesRead = filePosAfter - filePosBefore; bytesRead != length) {
+    if (const auto bytesRead = reader.get_pos() - posBefore; bytesRead != length) {
         return std::unexpected(std::format("Length mismatch. Length was {}, however {} bytes was read", length, bytesRead));
     }
     return tables;
 }
 
 auto FileParser::Jpeg::Parser::parseScanHeaderComponent(
-    std::ifstream& file
+    IO::ByteSpanReader& reader
 ) -> std::expected<ScanComponent, std::string> {
-    ASSIGN_OR_RETURN(selector,    read_uint8(file), "Unable to read component selector");
-    ASSIGN_OR_RETURN(destination, read_uint8(file), "Unable to read table destination");
+    BYTEREADER_READ_OR_RETURN(const, selector,    reader, read_u8(), std::unexpected("Unable to read component selector"));
+    BYTEREADER_READ_OR_RETURN(const, destination, reader, read_u8(), std::unexpected("Unable to read table destination"));
 
     ScanComponent component {
         .componentSelector = selector,
@@ -211,21 +209,26 @@ auto FileParser::Jpeg::Parser::parseScanHeaderComponent(
     return component;
 }
 
-auto FileParser::Jpeg::Parser::parseScanHeader(std::ifstream& file) -> std::expected<ScanHeader, std::string> {
+auto FileParser::Jpeg::Parser::parseScanHeader(IO::ByteSpanReader& reader) -> std::expected<ScanHeader, std::string> {
     READ_LENGTH();
-    ASSIGN_OR_RETURN(numberOfComponents, read_uint8(file), "Unable to read number of components");
+    BYTEREADER_READ_OR_RETURN(const, numberOfComponents, reader, read_u8(), std::unexpected("Unable to read number of components"));
     const auto expectedLength = static_cast<uint16_t>(6 + 2 * numberOfComponents);
     REQUIRE_LENGTH(length, expectedLength);
 
+    if (numberOfComponents < 1 || numberOfComponents > MaxScanComponents) {
+        return std::unexpected(std::format("Number of components in a scan must be between 1 and {}, got {}",
+            MaxScanComponents, numberOfComponents));
+    }
+
     ScanHeader scanHeader;
     for (uint8_t i = 0; i < numberOfComponents; ++i) {
-        ASSIGN_OR_RETURN(component, parseScanHeaderComponent(file), "Unable to read scan header component");
+        ASSIGN_OR_RETURN(component, parseScanHeaderComponent(reader), "Unable to read scan header component");
         scanHeader.components.push_back(component);
     }
 
-    ASSIGN_OR_RETURN(ss, read_uint8(file), "Unable to read spectral selection start");
-    ASSIGN_OR_RETURN(se, read_uint8(file), "Unable to read spectral selection end");
-    ASSIGN_OR_RETURN(approximation, read_uint8(file), "Unable to read approximation");
+    BYTEREADER_READ_OR_RETURN(const, ss,            reader, read_u8(), std::unexpected("Unable to read spectral selection start"));
+    BYTEREADER_READ_OR_RETURN(const, se,            reader, read_u8(), std::unexpected("Unable to read spectral selection end"));
+    BYTEREADER_READ_OR_RETURN(const, approximation, reader, read_u8(), std::unexpected("Unable to read approximation"));
 
     scanHeader.spectralSelectionStart = ss;
     scanHeader.spectralSelectionEnd   = se;
@@ -234,65 +237,66 @@ auto FileParser::Jpeg::Parser::parseScanHeader(std::ifstream& file) -> std::expe
     return scanHeader;
 }
 
-auto FileParser::Jpeg::Parser::parseECS(std::ifstream& file) -> std::expected<std::vector<std::vector<uint8_t>>, std::string> {
-    uint8_t pair[2];
-    if (!file.read(reinterpret_cast<char *>(pair), 2)) {
-        return std::unexpected("Unable to parse ECS");
-    }
-
-    size_t currentSection = 0;
-    std::vector sections(1, std::vector<uint8_t>());
+auto FileParser::Jpeg::Parser::parseECS(IO::ByteSpanReader& reader) -> std::expected<std::vector<DataSection>, std::string> {
+    // Only record where the sections are, the bit reader unstuffs the data while decoding. Everything between two
+    // 0xFF bytes is plain data, so the search jumps from one 0xFF to the next
+    const size_t start = reader.get_pos();
+    const auto bytes = reader.remaining_bytes();
+    size_t position = 0;
+    std::vector sections(1, DataSection{.offset = start});
     uint8_t prevRST = RST7; // Init to the last RST
 
-#define shiftByte()  \
-    pair[0] = pair[1]; \
-    const auto nextByte = read_uint8(file); \
-    if (!nextByte) { \
-        return utils::getUnexpected(nextByte, "Unable to parse ECS"); \
-    } \
-    pair[1] = *nextByte; \
-
     while (true) {
-        if (pair[0] == MarkerHeader) {
-            if (pair[1] == ByteStuffing) {
-                // If we encounter 0xFF00 for byte stuffing, it is treated as a literal 0xFF
-                sections[currentSection].push_back(pair[0]);
-                shiftByte();
-            } else if (isRST(pair[1])) {
-                if (getNextRST(prevRST) != pair[1]) {
-                    return std::unexpected("RST markers were not encountered in the correct order");
-                }
-                currentSection++;
-                sections.emplace_back();
-                prevRST = pair[1];
-                shiftByte();
-            } else {
-                // Encountered different marker, noting the end of the ECS
-                file.seekg(-2, std::ios::cur);
-                return sections;
+        position = findMarkerHeader(bytes, position);
+        if (position + 1 >= bytes.size()) {
+            return std::unexpected("Unable to parse ECS");
+        }
+        const uint8_t next = bytes[position + 1];
+        if (next == ByteStuffing) {
+            // 0xFF00 is a literal 0xFF
+            position += 2;
+            continue;
+        }
+
+        sections.back().length = start + position - sections.back().offset;
+        if (isRST(next)) {
+            if (getNextRST(prevRST) != next) {
+                return std::unexpected("RST markers were not encountered in the correct order");
             }
+            prevRST = next;
+            position += 2;
+            sections.push_back(DataSection{.offset = start + position});
         } else {
-            sections[currentSection].push_back(pair[0]);
+            // Encountered different marker, noting the end of the ECS
+            reader.set_pos(start + position);
+            return sections;
         }
-        shiftByte();
     }
-#undef shiftByte
 }
 
-auto FileParser::Jpeg::Parser::parseSOS(std::ifstream& file) -> std::expected<Scan, std::string> {
-    ASSIGN_OR_RETURN(header, parseScanHeader(file), "Unable to read scan header");
-    ASSIGN_OR_RETURN_MUT(ecs, parseECS(file), "Unable to read ecs");
+auto FileParser::Jpeg::Parser::parseSOS(IO::ByteSpanReader& reader) -> std::expected<Scan, std::string> {
+    ASSIGN_OR_RETURN(header, parseScanHeader(reader), "Unable to read scan header");
+    ASSIGN_OR_RETURN_MUT(ecs, parseECS(reader), "Unable to read ecs");
     return Scan { .header = header, .restartInterval = 0, .iterations = {}, .dataSections = std::move(ecs) };
 }
 
-auto FileParser::Jpeg::Parser::parseEOI(std::ifstream& file) -> std::expected<void, std::string> {
-    char dummy;
-    if (file.read(&dummy, 1)) {
+auto FileParser::Jpeg::Parser::parseEOI(const IO::ByteSpanReader& reader) -> std::expected<void, std::string> {
+    if (!reader.remaining_bytes().empty()) {
         return std::unexpected("Unexpected bytes encountered after EOI marker");
     }
     return {};
 }
 
+auto FileParser::Jpeg::Parser::skipSegment(IO::ByteSpanReader& reader) -> std::expected<void, std::string> {
+    READ_LENGTH();
+    if (length < 2) {
+        return std::unexpected(std::format("Segment length must be at least 2, got {}", length));
+    }
+    BYTEREADER_CALL_VOID_OR_RETURN(reader, forward_pos(length - 2u),
+        std::unexpected(std::format("Segment of length {} runs past the end of the file", length)));
+    return {};
+}
+
 auto FileParser::Jpeg::Parser::analyzeFrameHeader(const FrameHeader& header, const uint8_t SOF) -> std::expected<FrameInfo, std::string> {
     FrameInfo info;
     info.frameMarker = SOF;
@@ -334,27 +338,28 @@ auto FileParser::Jpeg::Parser::analyzeFrameHeader(const FrameHeader& header, con
     return info;
 }
 
-auto FileParser::Jpeg::Parser::parseFile(
-    const std::filesystem::path& filePath
-) -> std::expected<JpegData, std::string> {
-    ASSIGN_OR_PROPAGATE_MUT(file, FileUtils::openRegularFile(filePath, std::ios::binary));
+auto FileParser::Jpeg::Parser::parse(const std::span<const uint8_t> bytes) -> std::expected<JpegData, std::string> {
+    JpegData data;
+    auto reader = IO::ByteSpanReader::from_bytes(bytes);
 
     uint8_t soiBytes[2];
-    CHECK_VOID_AND_RETURN(read_bytes(reinterpret_cast<char *>(soiBytes), file, 2), "Unable to parse SOI");
+    BYTEREADER_CALL_VOID_OR_RETURN(reader, read_into(soiBytes, 2), std::unexpected("Unable to parse SOI"));
     if (soiBytes[0] != MarkerHeader || soiBytes[1] != SOI) {
         return std::unexpected("File must start with SOI marker");
     }
 
     std::unordered_set encounteredMarkers{SOI};
-    JpegData data;
-    uint8_t byte;
-    while (file.read(reinterpret_cast<char*>(&byte), 1)) {
-        if (byte == 0xFF) {
-            uint8_t marker;
-            file.read(reinterpret_cast<char*>(&marker), 1);
+    while (!reader.remaining_bytes().empty()) {
+        if (const uint8_t byte = reader.read_u8(); byte == MarkerHeader) {
+            BYTEREADER_READ_OR_RETURN(const, marker, reader, read_u8(), std::unexpected("Unable to read marker"));
+            if (marker == MarkerHeader) {
+                // Any number of 0xFF fill bytes may come before a marker
+                reader.rewind_pos(1);
+                continue;
+            }
             switch (marker) {
                 case DHT: {
-                    ASSIGN_OR_RETURN_MUT(huffmanParseResults, parseDHT(file), "Unable to parse DHT data");
+                    ASSIGN_OR_RETURN_MUT(huffmanParseResults, parseDHT(reader), "Unable to parse DHT data");
                     for (auto& [tableClass, tableDestination, table] : huffmanParseResults) {
                         auto& tableVec = tableClass == 0 ? data.huffmanTables.dc : data.huffmanTables.ac;
                         tableVec[tableDestination].push_back(std::move(table));
@@ -362,7 +367,7 @@ auto FileParser::Jpeg::Parser::parseFile(
                     break;
                 }
                 case DQT: {
-                    ASSIGN_OR_RETURN_MUT(quantizationTables, parseDQT(file), "Unable to parse DQT data");
+                    ASSIGN_OR_RETURN_MUT(quantizationTables, parseDQT(reader), "Unable to parse DQT data");
                     for (const auto& table : quantizationTables) {
                         data.quantizationTables[table.destination].push_back(table);
                     }
@@ -372,22 +377,22 @@ auto FileParser::Jpeg::Parser::parseFile(
                     if (encounteredMarkers.contains(DNL)) {
                         return std::unexpected("Multiple DNL markers encountered. Only one DNL marker is allowed");
                     }
-                    ASSIGN_OR_RETURN(numberOfLines, parseDNL(file), "Unable to parse DNL");
+                    ASSIGN_OR_RETURN(numberOfLines, parseDNL(reader), "Unable to parse DNL");
                     data.frameInfo.header.numberOfLines = numberOfLines;
                     break;
                 }
                 case DRI: {
-                    ASSIGN_OR_RETURN(restartInterval, parseDRI(file), "Unable to parse restart interval");
+                    ASSIGN_OR_RETURN(restartInterval, parseDRI(reader), "Unable to parse restart interval");
                     data.lastSetRestartInterval = restartInterval;
                     break;
                 }
                 case COM: {
-                    ASSIGN_OR_RETURN_MUT(comment, parseComment(file), "Unable to parse comment");
+                    ASSIGN_OR_RETURN_MUT(comment, parseComment(reader), "Unable to parse comment");
                     data.comments.push_back(std::move(comment));
                     break;
                 }
                 case SOS: {
-                    ASSIGN_OR_RETURN_MUT(scan, parseSOS(file), "Unable to parse SOS");
+                    ASSIGN_OR_RETURN_MUT(scan, parseSOS(reader), "Unable to parse SOS");
                     scan.restartInterval = data.lastSetRestartInterval;
                     for (size_t i = 0; i < 4; i++) {
                         scan.iterations.quantization[i] = data.quantizationTables[i].size() - 1;
@@ -414,7 +419,7 @@ auto FileParser::Jpeg::Parser::parseFile(
                     break;
                 }
                 case EOI: {
-                    CHECK_VOID_OR_PROPAGATE(parseEOI(file));
+                    CHECK_VOID_OR_PROPAGATE(parseEOI(reader));
                     break;
                 }
                 default: {
@@ -422,9 +427,15 @@ auto FileParser::Jpeg::Parser::parseFile(
                         if (std::ranges::any_of(encounteredMarkers, [](const uint8_t m) { return isSOF(m); })) {
                             return std::unexpected("Multiple SOF markers encountered. Only one SOF marker is allowed");
                         }
-                        ASSIGN_OR_RETURN(frameHeader, parseFrameHeader(file, marker), "Unable to parse frame header");
+                        if (marker != SOF0) {
+                            return std::unexpected(std::format(R"(Unsupported start of frame marker: "{}")", marker));
+                        }
+                        ASSIGN_OR_RETURN(frameHeader, parseFrameHeader(reader), "Unable to parse frame header");
                         ASSIGN_OR_RETURN_MUT(frameInfo, analyzeFrameHeader(frameHeader, marker), "Unable to analyze frame header");
                         data.frameInfo = std::move(frameInfo);
+                    } else if (!isStandalone(marker)) {
+                        // APPn (EXIF, ICC profiles, XMP, ...) and any other segment that is not needed for decoding
+                        CHECK_VOID_AND_RETURN(skipSegment(reader), std::format("Unable to skip segment of marker {:#04X}", marker));
                     }
                 }
             }
@@ -457,6 +468,101 @@ auto FileParser::Jpeg::Parser::parseFile(
     return data;
 }
 
+auto FileParser::Jpeg::Parser::parseFile(
+    const std::filesystem::path& filePath
+) -> std::expected<JpegData, std::string> {
+    ASSIGN_OR_PROPAGATE_MUT(bytes, FileUtils::readFileBytes(filePath));
+    ASSIGN_OR_PROPAGATE_MUT(data, parse(bytes));
+    // Entropy-coded data is decoded straight from the file bytes, so keep them with the parsed data
+    data.bytes = std::move(bytes);
+    return std::move(data);
+}
+
+auto FileParser::Jpeg::Parser::probe(const std::span<const uint8_t> bytes) -> std::expected<ProbeInfo, std::string> {
+    bool truncated = false;
+    return probe(bytes, truncated);
+}
+
+auto FileParser::Jpeg::Parser::probe(
+    const std::span<const uint8_t> bytes,
+    bool& truncated
+) -> std::expected<ProbeInfo, std::string> {
+    truncated = false;
+    auto reader = IO::ByteSpanReader::from_bytes(bytes);
+    // Only a segment that runs past the end of bytes can be complete in the rest of the file
+    auto segmentFits = [&reader] {
+        const auto remaining = reader.remaining_bytes();
+        return remaining.size() >= 2 && (static_cast<size_t>(remaining[0]) << 8 | remaining[1]) <= remaining.size();
+    };
+
+    uint8_t soiBytes[2];
+    truncated = bytes.size() < sizeof(soiBytes);
+    BYTEREADER_CALL_VOID_OR_RETURN(reader, read_into(soiBytes, 2), std::unexpected("Unable to parse SOI"));
+    if (soiBytes[0] != MarkerHeader || soiBytes[1] != SOI) {
+        return std::unexpected("File must start with SOI marker");
+    }
+
+    ProbeInfo info;
+    while (!reader.remaining_bytes().empty()) {
+        if (reader.read_u8() != MarkerHeader || reader.remaining_bytes().empty()) {
+            continue;
+        }
+        BYTEREADER_READ_OR_RETURN(const, marker, reader, read_u8(), std::unexpected("Unable to read marker"));
+        if (marker != MarkerHeader && !isStandalone(marker) && !segmentFits()) {
+            truncated = true;
+            return std::unexpected(std::format("Segment of marker {:#04X} runs past the end of the data", marker));
+        }
+        if (marker == MarkerHeader) {
+            reader.rewind_pos(1);
+        } else if (isSOF(marker)) {
+            if (info.frameMarker != 0) {
+                return std::unexpected("Multiple SOF markers encountered. Only one SOF marker is allowed");
+            }
+            ASSIGN_OR_RETURN_MUT(frameHeader, parseFrameHeader(reader), "Unable to parse frame header");
+            info.frameMarker = marker;
+            info.frameHeader = std::move(frameHeader);
+        } else if (marker == SOS) {
+            if (info.frameMarker == 0) {
+                return std::unexpected("Missing SOF (Start of Frame) marker");
+            }
+            ASSIGN_OR_RETURN_MUT(scanHeader, parseScanHeader(reader), "Unable to read scan header");
+            info.firstScan = std::move(scanHeader);
+            return info;
+        } else if (marker == EOI) {
+            return std::unexpected("No SOS (Start of Scan) marker found");
+        } else if (!isStandalone(marker)) {
+            CHECK_VOID_AND_RETURN(skipSegment(reader), std::format("Unable to skip segment of marker {:#04X}", marker));
+        }
+    }
+    truncated = true;
+    return std::unexpected("No SOS (Start of Scan) marker found");
+}
+
+auto FileParser::Jpeg::probe(const std::filesystem::path& filePath) -> std::expected<ProbeInfo, std::string> {
+    // Enough for the headers of most files. Files with large APPn segments (EXIF thumbnails, ICC profiles) are reread
+    // with a larger prefix until the first SOS fits, but any other failure is final
+    size_t prefixSize = 4 * 1024;
+    while (true) {
+        ASSIGN_OR_PROPAGATE(bytes, FileUtils::readFilePrefix(filePath, prefixSize));
+        bool truncated = false;
+        auto info = Parser::probe(bytes, truncated);
+        if (info || !truncated || bytes.size() < prefixSize) {
+            return info;
+        }
+        prefixSize *= 4;
+    }
+}
+
+auto FileParser::Jpeg::toString(const DecodeError error) -> std::string_view {
+    switch (error) {
+        case DecodeError::InvalidHuffmanCode: return "Huffman encoding does not exist";
+        case DecodeError::InvalidDcCategory:  return "Invalid SSSS value in DC coefficient";
+        case DecodeError::InvalidAcCategory:  return "Invalid SSSS value in AC coefficient";
+        case DecodeError::RunLengthOverflow:  return "Run length would exceed component bounds";
+    }
+    return "Unknown decode error";
+}
+
 auto FileParser::Jpeg::Decoder::isEOB(const int r, const int s) -> bool {
     return r == 0x0 && s == 0x0;
 }
@@ -466,54 +572,174 @@ auto FileParser::Jpeg::Decoder::isZRL(const int r, const int s) -> bool {
 }
 
 int FileParser::Jpeg::Decoder::decodeSSSS(BitReader& bitReader, const int SSSS) {
-    int coefficient = static_cast<int>(bitReader.getNBits(static_cast<size_t>(SSSS)));
-    if (coefficient < 1 << (SSSS - 1)) {
-        coefficient -= (1 << SSSS) - 1;
-    }
-    return coefficient;
+    const int bits = static_cast<int>(bitReader.getNBits(static_cast<size_t>(SSSS)));
+    // Values with a leading 0 bit are negative: subtract 2^SSSS - 1 from them without branching
+    const int isNegative = (bits >> (SSSS - 1)) - 1; // -1 if the leading bit is 0, otherwise 0
+    return bits + (isNegative & (1 - (1 << SSSS)));
 }
 
-auto FileParser::Jpeg::Decoder::decodeNextValue(BitReader& bitReader, const HuffmanTable& huffmanTable) -> uint8_t {
+auto FileParser::Jpeg::Decoder::decodeNextValue(
+    BitReader& bitReader, const HuffmanTable& huffmanTable
+) -> std::expected<uint8_t, DecodeError> {
     auto [bitLength, value] = huffmanTable.decode(bitReader.peekUInt16());
+    if (bitLength == 0) {
+        return std::unexpected(DecodeError::InvalidHuffmanCode);
+    }
     bitReader.skipBits(bitLength);
     return value;
 }
 
-int FileParser::Jpeg::Decoder::decodeDcCoefficient(BitReader& bitReader, const HuffmanTable& huffmanTable) {
-    const int sCategory = decodeNextValue(bitReader, huffmanTable);
-    return sCategory == 0 ? 0 : decodeSSSS(bitReader, sCategory);
+auto FileParser::Jpeg::Decoder::decodeDcCoefficient(
+    BitReader& bitReader, const HuffmanTable& huffmanTable
+) -> std::expected<int, DecodeError> {
+    // A DC symbol is a bare SSSS category, which decodes the same way as an AC symbol with a run of 0
+    ASSIGN_OR_PROPAGATE(rs, decodeAcCoefficient(bitReader, huffmanTable));
+    if (rs.r != 0 || rs.s > 11) {
+        return std::unexpected(DecodeError::InvalidDcCategory);
+    }
+    return rs.coefficient;
 }
 
 auto FileParser::Jpeg::Decoder::decodeAcCoefficient(
     BitReader& bitReader, const HuffmanTable& huffmanTable
-) -> ACCoefficientResult {
-    const uint8_t rs = decodeNextValue(bitReader, huffmanTable);
-    return {getUpperNibble(rs), getLowerNibble(rs)};
+) -> std::expected<ACCoefficientResult, DecodeError> {
+    const uint16_t word = bitReader.peekUInt16();
+    if (const auto& fused = huffmanTable.decodeFused(word); fused.bitLength != 0) {
+        bitReader.skipBits(fused.bitLength);
+        return ACCoefficientResult{getUpperNibble(fused.value), getLowerNibble(fused.value), fused.coefficient};
+    }
+    ASSIGN_OR_PROPAGATE(rs, decodeNextValue(bitReader, huffmanTable));
+    const int s = getLowerNibble(rs);
+    return ACCoefficientResult{getUpperNibble(rs), s, s == 0 ? 0 : decodeSSSS(bitReader, s)};
 }
 
-auto FileParser::Jpeg::Decoder::decodeComponent(
-    Component& out,
+auto FileParser::Jpeg::Decoder::countDataSections(const FrameInfo& frame, const Scan& scan) -> std::expected<size_t, std::string> {
+    const size_t totalMcus   = static_cast<size_t>(frame.mcuWidth) * frame.mcuHeight;
+    const size_t sectionMcus = scan.restartInterval != 0 ? scan.restartInterval : totalMcus;
+    // Some encoders emit an RST marker after the final interval, which leaves an empty section at the end
+    const size_t expectedSections = utils::ceilDivide(totalMcus, sectionMcus);
+    const bool hasOnlyEmptyExtraSections = std::ranges::all_of(
+        scan.dataSections | std::views::drop(expectedSections), [](const DataSection& section) { return section.length == 0; });
+    if (scan.dataSections.size() < expectedSections || !hasOnlyEmptyExtraSections) {
+        return std::unexpected(std::format("Expected {} RST segments in scan, found {}", expectedSections, scan.dataSections.size()));
+    }
+    return expectedSections;
+}
+
+auto FileParser::Jpeg::Decoder::createPlanes(
+    const FrameInfo& frame, const size_t mcuLines, const bool lumaOnly
+) -> std::vector<CoefficientPlane> {
+    std::vector<CoefficientPlane> planes;
+    planes.reserve(frame.header.components.size());
+    for (const auto& component : frame.header.components) {
+        const bool isLuminance = component.identifier == frame.luminanceID;
+        if (lumaOnly && !isLuminance) {
+            planes.emplace_back();
+            continue;
+        }
+        const size_t horizontal = isLuminance ? frame.luminanceHorizontalSamplingFactor : 1u;
+        const size_t vertical   = isLuminance ? frame.luminanceVerticalSamplingFactor   : 1u;
+        planes.emplace_back(frame.mcuWidth * horizontal, mcuLines * vertical);
+    }
+    return planes;
+}
+
+auto FileParser::Jpeg::Decoder::getMcuLayout(
+    const FrameInfo& frame, const ScanHeader& scanHeader, const DecodeScale scale, const bool lumaOnly
+) -> McuLayout {
+    const McuGeometry geometry = getMcuGeometry(frame, scale);
+    McuLayout layout;
+    for (size_t i = 0; i < scanHeader.components.size(); i++) {
+        const auto id = scanHeader.components[i].componentSelector;
+        if (id != frame.luminanceID && id != frame.chrominanceBlueID && id != frame.chrominanceRedID) {
+            continue;
+        }
+        const auto frameComp = std::ranges::find_if(frame.header.components, [id](const FrameComponent& c) { return c.identifier == id; });
+        const size_t planeIndex = static_cast<size_t>(frameComp - frame.header.components.begin());
+        // Only the luminance component may be sampled more than once per MCU
+        const size_t horizontal = id == frame.luminanceID ? frame.luminanceHorizontalSamplingFactor : 1u;
+        const size_t vertical   = id == frame.luminanceID ? frame.luminanceVerticalSamplingFactor   : 1u;
+        const size_t transformSize = id == frame.luminanceID ? geometry.blockSize : geometry.chromaSize;
+        for (size_t row = 0; row < vertical; row++) {
+            for (size_t col = 0; col < horizontal; col++) {
+                layout.push_back({
+                    .scanComponentIndex = i, .planeIndex = planeIndex, .rowOffset = row, .colOffset = col,
+                    .horizontalSamplingFactor = horizontal, .verticalSamplingFactor = vertical,
+                    .skipped = lumaOnly && id != frame.luminanceID, .dcOnly = transformSize == 1
+                });
+            }
+        }
+    }
+    return layout;
+}
+
+auto FileParser::Jpeg::Decoder::getBlock(
+    const std::span<CoefficientPlane> planes, const FrameInfo& frame, const size_t mcuIndex, const McuBlock& block
+) -> CoefficientBlock& {
+    const size_t mcuRow = mcuIndex / frame.mcuWidth;
+    const size_t mcuCol = mcuIndex % frame.mcuWidth;
+    return planes[block.planeIndex].getBlock(
+        mcuRow * block.verticalSamplingFactor   + block.rowOffset,
+        mcuCol * block.horizontalSamplingFactor + block.colOffset);
+}
+
+auto FileParser::Jpeg::Decoder::getLastNonzero(
+    const std::span<CoefficientPlane> planes, const FrameInfo& frame, const size_t mcuIndex, const McuBlock& block
+) -> uint8_t& {
+    const size_t mcuRow = mcuIndex / frame.mcuWidth;
+    const size_t mcuCol = mcuIndex % frame.mcuWidth;
+    return planes[block.planeIndex].getLastNonzero(
+        mcuRow * block.verticalSamplingFactor   + block.rowOffset,
+        mcuCol * block.horizontalSamplingFactor + block.colOffset);
+}
+
+auto FileParser::Jpeg::Decoder::createDequantizationTables(
+    const FrameInfo& frame,
+    const ScanHeader& scanHeader,
+    const QuantizationTablePtrs& quantizationTables
+) -> std::expected<DequantizationTables, std::string> {
+    DequantizationTables result;
+    for (size_t i = 0; i < scanHeader.components.size() && i < result.size(); i++) {
+        ASSIGN_OR_PROPAGATE(frameComp, frame.header.getComponent(scanHeader.components[i].componentSelector));
+        const QuantizationTable* quantizationTable = quantizationTables[frameComp.quantizationTableSelector];
+        if (quantizationTable == nullptr) {
+            return std::unexpected("Quantization table was undefined");
+        }
+        for (size_t j = 0; j < CoefficientBlock::length; j++) {
+            // 16-bit tables can hold values past what an int16_t fits. Those only ever quantize coefficients to zero
+            const float value = std::min((*quantizationTable)[zigZagMap[j]], static_cast<float>(std::numeric_limits<int16_t>::max()));
+            result[i].multipliers[j] = static_cast<int16_t>(value);
+        }
+    }
+    return result;
+}
+
+auto FileParser::Jpeg::Decoder::decodeBlock(
+    CoefficientBlock& out,
+    uint8_t& lastNonzero,
     BitReader& bitReader,
-    const ScanComponent& scanComp,
-    const HuffmanTablePtrs& dcTables,
-    const HuffmanTablePtrs& acTables, PreviousDC& prevDc
-) -> std::expected<Component, std::string>  {
+    const HuffmanTable& dcTable,
+    const HuffmanTable& acTable,
+    const DequantizationTable& dequantizationTable,
+    const bool dcOnly
+) -> std::expected<void, DecodeError> {
     // DC Coefficient
-    const auto& dcTable = *dcTables[scanComp.dcTableSelector];
-    const int dcCoefficient = decodeDcCoefficient(bitReader, dcTable) + prevDc[scanComp.componentSelector];
-    out[0] = static_cast<float>(dcCoefficient);
-    prevDc[scanComp.componentSelector] = dcCoefficient;
+    ASSIGN_OR_PROPAGATE(dcDifference, decodeDcCoefficient(bitReader, dcTable));
+    out[0] = static_cast<int16_t>(dcDifference);
+    if (dcOnly) {
+        return skipAcCoefficients(bitReader, acTable);
+    }
 
     // AC Coefficients
     size_t index = 1;
-    while (index < Component::length) {
-        const auto& acTable = *acTables[scanComp.acTableSelector];
-        auto [r, s] = decodeAcCoefficient(bitReader, acTable);
-        if (static_cast<size_t>(r) > Component::length - index) {
-            return std::unexpected("Run length would exceed component bounds");
+    while (index < CoefficientBlock::length) {
+        ASSIGN_OR_PROPAGATE(rs, decodeAcCoefficient(bitReader, acTable));
+        const auto [r, s, coefficient] = rs;
+        if (static_cast<size_t>(r) > CoefficientBlock::length - index) {
+            return std::unexpected(DecodeError::RunLengthOverflow);
         }
         if (s < 0 || s > 10) {  // Typical JPEG SSSS range
-            return std::unexpected(std::format("Invalid SSSS value in AC coefficient: {}", s));
+            return std::unexpected(DecodeError::InvalidAcCategory);
         }
         if (isEOB(r, s)) { // Remaining coefficients are 0
             break;
@@ -523,81 +749,423 @@ auto FileParser::Jpeg::Decoder::decodeComponent(
             continue;
         }
         index += static_cast<size_t>(r);
-        const int coefficient = decodeSSSS(bitReader, s);
-        out[zigZagMap[index]] = static_cast<float>(coefficient);
+        if (index >= CoefficientBlock::length) {
+            return std::unexpected(DecodeError::RunLengthOverflow);
+        }
+        out[zigZagMap[index]] = static_cast<int16_t>(coefficient * dequantizationTable[index]);
+        lastNonzero = static_cast<uint8_t>(index);
         index++;
     }
-    return out;
+    return {};
+}
+
+auto FileParser::Jpeg::Decoder::skipAcCoefficients(
+    BitReader& bitReader,
+    const HuffmanTable& acTable
+) -> std::expected<void, DecodeError> {
+    size_t index = 1;
+    while (index < CoefficientBlock::length) {
+        // The fused lookup covers the extra bits too, otherwise they are skipped without being read
+        int r = 0;
+        int s = 0;
+        if (const auto& fused = acTable.decodeFused(bitReader.peekUInt16()); fused.bitLength != 0) {
+            bitReader.skipBits(fused.bitLength);
+            r = getUpperNibble(fused.value);
+            s = getLowerNibble(fused.value);
+        } else {
+            ASSIGN_OR_PROPAGATE(rs, decodeNextValue(bitReader, acTable));
+            r = getUpperNibble(rs);
+            s = getLowerNibble(rs);
+            bitReader.skipBits(static_cast<size_t>(s));
+        }
+        if (static_cast<size_t>(r) > CoefficientBlock::length - index) {
+            return std::unexpected(DecodeError::RunLengthOverflow);
+        }
+        if (s < 0 || s > 10) {
+            return std::unexpected(DecodeError::InvalidAcCategory);
+        }
+        if (isEOB(r, s)) {
+            break;
+        }
+        if (isZRL(r, s)) {
+            index += 16;
+            continue;
+        }
+        index += static_cast<size_t>(r);
+        if (index >= CoefficientBlock::length) {
+            return std::unexpected(DecodeError::RunLengthOverflow);
+        }
+        index++;
+    }
+    return {};
+}
+
+auto FileParser::Jpeg::Decoder::skipBlock(
+    BitReader& bitReader,
+    const HuffmanTable& dcTable,
+    const HuffmanTable& acTable
+) -> std::expected<void, DecodeError> {
+    ASSIGN_OR_PROPAGATE(dcDifference, decodeDcCoefficient(bitReader, dcTable));
+    return skipAcCoefficients(bitReader, acTable);
+}
+
+auto FileParser::Jpeg::Decoder::decodeComponent(
+    CoefficientBlock& out,
+    uint8_t& lastNonzero,
+    BitReader& bitReader,
+    const ScanComponent& scanComp,
+    const HuffmanTablePtrs& dcTables,
+    const HuffmanTablePtrs& acTables,
+    const DequantizationTable& dequantizationTable,
+    const bool dcOnly,
+    int& prevDc
+) -> std::expected<void, DecodeError>  {
+    CHECK_VOID_OR_PROPAGATE(decodeBlock(
+        out, lastNonzero, bitReader, *dcTables[scanComp.dcTableSelector], *acTables[scanComp.acTableSelector], dequantizationTable, dcOnly));
+    prevDc += out[0];
+    out[0] = static_cast<int16_t>(prevDc * dequantizationTable[0]);
+    return {};
+}
+
+auto FileParser::Jpeg::Decoder::skipMcu(
+    BitReader& bitReader,
+    const ScanHeader& scanHeader,
+    const McuLayout& layout,
+    const HuffmanTablePtrs& dcTables,
+    const HuffmanTablePtrs& acTables,
+    PreviousDC& prevDc
+) -> std::expected<void, DecodeError> {
+    // Only the DC predictors carry over to later MCUs, so nothing else is extended, dequantized or stored
+    for (const auto& block : layout) {
+        const auto& scanComp = scanHeader.components[block.scanComponentIndex];
+        ASSIGN_OR_PROPAGATE(dcDifference, decodeDcCoefficient(bitReader, *dcTables[scanComp.dcTableSelector]));
+        prevDc[block.scanComponentIndex] += dcDifference;
+        CHECK_VOID_OR_PROPAGATE(skipAcCoefficients(bitReader, *acTables[scanComp.acTableSelector]));
+    }
+    return {};
 }
 
 auto FileParser::Jpeg::Decoder::decodeMcu(
+    const std::span<CoefficientPlane> planes,
+    const size_t mcuIndex,
     BitReader& bitReader,
     const FrameInfo& frame,
     const ScanHeader& scanHeader,
+    const McuLayout& layout,
     const HuffmanTablePtrs& dcTables,
     const HuffmanTablePtrs& acTables,
+    const DequantizationTables& dequantizationTables,
     PreviousDC& prevDc
-) -> std::expected<Mcu, std::string> {
-    auto mcu = Mcu(frame.luminanceHorizontalSamplingFactor, frame.luminanceVerticalSamplingFactor);
-    for (const auto& scanComp : scanHeader.components) {
-        if (scanComp.componentSelector == frame.luminanceID) {
-            const auto numLuminanceComponents = static_cast<size_t>(frame.luminanceHorizontalSamplingFactor * frame.luminanceVerticalSamplingFactor);
-            for (size_t i = 0; i < numLuminanceComponents; i++) {
-                CHECK_VOID_AND_RETURN(
-                    decodeComponent(mcu.Y[i], bitReader, scanComp, dcTables, acTables, prevDc),
-                    "Unable to parse luminance component");
-            }
-        } else if (scanComp.componentSelector == frame.chrominanceBlueID) {
-            CHECK_VOID_AND_RETURN(
-                decodeComponent(mcu.Cb, bitReader, scanComp, dcTables, acTables, prevDc),
-                "Unable to parse chrominance blue component");
-        } else if (scanComp.componentSelector == frame.chrominanceRedID) {
-            CHECK_VOID_AND_RETURN(
-                decodeComponent(mcu.Cr, bitReader, scanComp, dcTables, acTables, prevDc),
-                "Unable to parse chrominance red component");
+) -> std::expected<void, DecodeError> {
+    for (const auto& block : layout) {
+        const auto& scanComp = scanHeader.components[block.scanComponentIndex];
+        if (block.skipped) {
+            CHECK_VOID_OR_PROPAGATE(skipBlock(bitReader, *dcTables[scanComp.dcTableSelector], *acTables[scanComp.acTableSelector]));
+            continue;
         }
+        CHECK_VOID_OR_PROPAGATE(decodeComponent(
+            getBlock(planes, frame, mcuIndex, block), getLastNonzero(planes, frame, mcuIndex, block), bitReader, scanComp, dcTables, acTables,
+            dequantizationTables[block.scanComponentIndex], block.dcOnly, prevDc[block.scanComponentIndex]));
     }
-    return mcu;
+    return {};
 }
 
 auto FileParser::Jpeg::Decoder::decodeRSTSegment(
+    const std::span<CoefficientPlane> planes,
+    const size_t firstMcu,
+    const size_t mcuCount,
     const FrameInfo& frame,
     const ScanHeader& scanHeader,
+    const McuLayout& layout,
     const HuffmanTablePtrs& dcTables,
     const HuffmanTablePtrs& acTables,
-    const uint16_t restartInterval,
-    const std::vector<uint8_t>& rstData
-) -> std::expected<std::vector<Mcu>, std::string> {
+    const DequantizationTables& dequantizationTables,
+    const std::span<const uint8_t> rstData
+) -> std::expected<void, std::string> {
     BitReader bitReader{rstData};
     PreviousDC prevDc{};
 
-    const size_t mcusToRead = restartInterval != 0 ? restartInterval : frame.mcuWidth * frame.mcuHeight;
-    std::vector<Mcu> mcus;
-    for (size_t i = 0; i < mcusToRead; i++) {
-        ASSIGN_OR_RETURN(mcu, decodeMcu(bitReader, frame, scanHeader, dcTables, acTables, prevDc), "Unable to decode MCU");
-        mcus.push_back(mcu);
+    for (size_t i = 0; i < mcuCount; i++) {
+        const auto result = decodeMcu(
+            planes, firstMcu + i, bitReader, frame, scanHeader, layout, dcTables, acTables, dequantizationTables, prevDc);
+        if (!result) {
+            return std::unexpected(std::format("Unable to decode MCU {}: {}", i, toString(result.error())));
+        }
     }
+    return finishRSTSegment(bitReader);
+}
 
+auto FileParser::Jpeg::Decoder::finishRSTSegment(BitReader& bitReader) -> std::expected<void, std::string> {
     bitReader.alignToByte();
     if (!bitReader.reachedEnd()) {
         return std::unexpected("Extra unused data found before the end of RST marker");
     }
-    return mcus;
+    return {};
+}
+
+namespace {
+    struct SpeculativeBlock {
+        size_t bitPosition = 0; // Where the block starts in the unstuffed scan data
+        size_t slot        = 0; // Which block of an MCU it was decoded as
+        size_t segment     = 0; // Blocks in the same segment were decoded back to back
+        FileParser::Jpeg::CoefficientBlock coefficients{};
+        uint8_t lastNonzero = 0;
+    };
+
+    // Blocks decoded from a guessed starting point, restarting one bit further on whenever the guess fails to decode
+    struct SpeculativeChunk {
+        std::vector<SpeculativeBlock> blocks;
+        std::vector<FileParser::Jpeg::BitReader> segmentEnds; // The reader right after the last block of each segment
+    };
+
+    // A run of speculative blocks confirmed to match the real decoding
+    struct AdoptedRun {
+        size_t chunkIndex = 0;
+        size_t firstBlock = 0;
+        size_t blockCount = 0;
+        size_t outputBlock = 0;
+    };
+}
+
+auto FileParser::Jpeg::Decoder::decodeSpeculatively(
+    const std::span<CoefficientPlane> planes,
+    const FrameInfo& frame,
+    const ScanHeader& scanHeader,
+    const McuLayout& layout,
+    const HuffmanTablePtrs& dcTables,
+    const HuffmanTablePtrs& acTables,
+    const DequantizationTables& dequantizationTables,
+    const std::span<const uint8_t> data,
+    const size_t chunkCount
+) -> std::expected<void, std::string> {
+    const size_t blocksPerMcu = layout.size();
+    const size_t totalBlocks  = static_cast<size_t>(frame.mcuWidth) * frame.mcuHeight * blocksPerMcu;
+
+    auto blockAt = [&](const size_t blockIndex) -> CoefficientBlock& {
+        return getBlock(planes, frame, blockIndex / blocksPerMcu, layout[blockIndex % blocksPerMcu]);
+    };
+    auto lastNonzeroAt = [&](const size_t blockIndex) -> uint8_t& {
+        return getLastNonzero(planes, frame, blockIndex / blocksPerMcu, layout[blockIndex % blocksPerMcu]);
+    };
+    auto decodeBlockAt = [&](CoefficientBlock& block, uint8_t& lastNonzero, BitReader& bitReader, const size_t blockIndex) {
+        const auto& mcuBlock = layout[blockIndex % blocksPerMcu];
+        const size_t scanComponentIndex = mcuBlock.scanComponentIndex;
+        const auto& scanComp = scanHeader.components[scanComponentIndex];
+        if (mcuBlock.skipped) {
+            return skipBlock(bitReader, *dcTables[scanComp.dcTableSelector], *acTables[scanComp.acTableSelector]);
+        }
+        return decodeBlock(block, lastNonzero, bitReader, *dcTables[scanComp.dcTableSelector], *acTables[scanComp.acTableSelector],
+                           dequantizationTables[scanComponentIndex], mcuBlock.dcOnly);
+    };
+    // Skipped blocks have no plane to go to, so only their symbols are walked
+    auto decodeOutputBlock = [&](BitReader& bitReader, const size_t blockIndex) -> std::expected<void, DecodeError> {
+        if (const auto& mcuBlock = layout[blockIndex % blocksPerMcu]; mcuBlock.skipped) {
+            const auto& scanComp = scanHeader.components[mcuBlock.scanComponentIndex];
+            return skipBlock(bitReader, *dcTables[scanComp.dcTableSelector], *acTables[scanComp.acTableSelector]);
+        }
+        return decodeBlockAt(blockAt(blockIndex), lastNonzeroAt(blockIndex), bitReader, blockIndex);
+    };
+
+    // Chunks start at evenly spaced bytes, but never on the 0x00 of a stuffed 0xFF00
+    constexpr size_t bitsInByte = 8;
+    std::vector<size_t> startBytes(chunkCount + 1, data.size());
+    for (size_t chunkIndex = 0; chunkIndex < chunkCount; chunkIndex++) {
+        size_t startByte = data.size() * chunkIndex / chunkCount;
+        if (startByte > 0 && data[startByte - 1] == MarkerHeader) startByte++;
+        startBytes[chunkIndex] = chunkIndex == 0 ? 0 : std::max(startByte, startBytes[chunkIndex - 1]);
+    }
+
+    // Every 0xFF in the data is followed by a stuffed byte, which does not count towards bit positions
+    std::vector<size_t> stuffedBytes(chunkCount);
+    ThreadPool::shared().parallelFor(chunkCount, [&](const size_t chunkIndex) {
+        const auto chunkBytes = data.subspan(startBytes[chunkIndex], startBytes[chunkIndex + 1] - startBytes[chunkIndex]);
+        stuffedBytes[chunkIndex] = static_cast<size_t>(std::ranges::count(chunkBytes, MarkerHeader));
+    });
+    std::vector<size_t> startBitPositions(chunkCount + 1);
+    size_t stuffedBefore = 0;
+    for (size_t chunkIndex = 0; chunkIndex <= chunkCount; chunkIndex++) {
+        startBitPositions[chunkIndex] = (startBytes[chunkIndex] - stuffedBefore) * bitsInByte;
+        if (chunkIndex < chunkCount) stuffedBefore += stuffedBytes[chunkIndex];
+    }
+
+    // Decode every chunk as if it began with the first block of an MCU
+    std::vector<SpeculativeChunk> chunks(chunkCount);
+    ThreadPool::shared().parallelFor(chunkCount, [&](const size_t chunkIndex) {
+        auto& chunk = chunks[chunkIndex];
+        auto endSegment = [&chunk](const BitReader& reader) {
+            if (!chunk.blocks.empty() && chunk.blocks.back().segment == chunk.segmentEnds.size()) {
+                chunk.segmentEnds.push_back(reader);
+            }
+        };
+
+        // Blocks starting in the last byte are left to stitching, so the final chunk cannot mistake padding for a block
+        const size_t endBitPosition = startBitPositions[chunkIndex + 1];
+        BitReader bitReader{data, startBytes[chunkIndex], startBitPositions[chunkIndex]};
+        size_t slot = 0;
+        while (bitReader.getBitPosition() + bitsInByte <= endBitPosition && chunk.blocks.size() < totalBlocks) {
+            const BitReader blockStart = bitReader;
+            SpeculativeBlock block{.bitPosition = bitReader.getBitPosition(), .slot = slot, .segment = chunk.segmentEnds.size()};
+            if (!decodeBlockAt(block.coefficients, block.lastNonzero, bitReader, slot)) {
+                endSegment(blockStart);
+                bitReader = blockStart;
+                bitReader.skipBits(1);
+                slot = 0;
+                continue;
+            }
+            slot = (slot + 1) % blocksPerMcu;
+            chunk.blocks.push_back(std::move(block));
+        }
+        endSegment(bitReader);
+    });
+
+    // Walk the real bitstream, jumping ahead whenever it lands on a block start that a chunk decoded the same way
+    BitReader bitReader{data};
+    size_t decodedBlocks = 0;
+    auto blockFailure = [&](const DecodeError error) {
+        return std::unexpected(std::format("Unable to decode MCU {}: {}", decodedBlocks / blocksPerMcu, toString(error)));
+    };
+    std::vector<AdoptedRun> adoptedRuns;
+    for (size_t chunkIndex = 0; chunkIndex < chunkCount && decodedBlocks < totalBlocks; chunkIndex++) {
+        const auto& chunk = chunks[chunkIndex];
+        size_t candidate = 0;
+        while (decodedBlocks < totalBlocks) {
+            const size_t bitPosition = bitReader.getBitPosition();
+            while (candidate < chunk.blocks.size() && chunk.blocks[candidate].bitPosition < bitPosition) {
+                candidate++;
+            }
+            if (candidate == chunk.blocks.size()) {
+                break; // Passed every block of this chunk without syncing
+            }
+            const bool inSync = chunk.blocks[candidate].bitPosition == bitPosition &&
+                                chunk.blocks[candidate].slot == decodedBlocks % blocksPerMcu;
+            if (inSync) {
+                // Adopt blocks for as long as the chunk decoded them back to back
+                size_t last = candidate;
+                while (last + 1 < chunk.blocks.size() && chunk.blocks[last + 1].segment == chunk.blocks[candidate].segment) {
+                    last++;
+                }
+                const size_t blockCount = last + 1 - candidate;
+                if (blockCount > totalBlocks - decodedBlocks) {
+                    // The extra blocks start at least a byte before the end, so a serial decode would fail the same way
+                    return std::unexpected("Extra unused data found at the end of the scan");
+                }
+                adoptedRuns.push_back({
+                    .chunkIndex = chunkIndex, .firstBlock = candidate, .blockCount = blockCount, .outputBlock = decodedBlocks
+                });
+                decodedBlocks += blockCount;
+                candidate = last + 1;
+                bitReader = chunk.segmentEnds[chunk.blocks[last].segment];
+                continue;
+            }
+            if (const auto result = decodeOutputBlock(bitReader, decodedBlocks); !result) {
+                return blockFailure(result.error());
+            }
+            decodedBlocks++;
+        }
+    }
+    for (; decodedBlocks < totalBlocks; decodedBlocks++) {
+        if (const auto result = decodeOutputBlock(bitReader, decodedBlocks); !result) {
+            return blockFailure(result.error());
+        }
+    }
+
+    bitReader.alignToByte();
+    if (!bitReader.reachedEnd()) {
+        return std::unexpected("Extra unused data found at the end of the scan");
+    }
+
+    ThreadPool::shared().parallelFor(adoptedRuns.size(), [&](const size_t runIndex) {
+        const auto& [chunkIndex, firstBlock, blockCount, outputBlock] = adoptedRuns[runIndex];
+        for (size_t i = 0; i < blockCount; i++) {
+            if (!layout[(outputBlock + i) % blocksPerMcu].skipped) {
+                const auto& block = chunks[chunkIndex].blocks[firstBlock + i];
+                blockAt(outputBlock + i)       = block.coefficients;
+                lastNonzeroAt(outputBlock + i) = block.lastNonzero;
+            }
+        }
+    });
+
+    // Blocks hold quantized DC differences until now, since chunks cannot know the predictor at their start
+    PreviousDC prevDc{};
+    for (size_t blockIndex = 0; blockIndex < totalBlocks; blockIndex++) {
+        if (layout[blockIndex % blocksPerMcu].skipped) {
+            continue;
+        }
+        auto& block = blockAt(blockIndex);
+        const size_t scanComponentIndex = layout[blockIndex % blocksPerMcu].scanComponentIndex;
+        int& predictor = prevDc[scanComponentIndex];
+        predictor += block[0];
+        block[0] = static_cast<int16_t>(predictor * dequantizationTables[scanComponentIndex][0]);
+    }
+    return {};
 }
 
 auto FileParser::Jpeg::Decoder::decodeScan(
-    const FrameInfo& frame, const Scan& scan, const HuffmanTablePtrs& dcTables, const HuffmanTablePtrs& acTables
-) -> std::expected<std::vector<Mcu>, std::string> {
-    std::vector<Mcu> mcus;
+    const FrameInfo& frame,
+    const Scan& scan,
+    const std::span<const uint8_t> fileBytes,
+    const HuffmanTablePtrs& dcTables,
+    const HuffmanTablePtrs& acTables,
+    const DequantizationTables& dequantizationTables,
+    const DecodeScale scale,
+    const bool lumaOnly
+) -> std::expected<std::vector<CoefficientPlane>, std::string> {
+    // Only scans without restart markers are split, and only when every chunk gets enough data to be worth it
+    const size_t scanBytes  = scan.dataSections.size() == 1 ? scan.dataSections[0].length : 0;
+    const size_t chunkCount = std::min(ThreadPool::shared().getThreadCount() + 1, scanBytes / minSpeculativeChunkBytes);
+    return decodeScan(frame, scan, fileBytes, dcTables, acTables, dequantizationTables, scale, lumaOnly, chunkCount);
+}
 
-    for (const auto& section : scan.dataSections) {
-        ASSIGN_OR_RETURN(decodedSection,
-            decodeRSTSegment(frame, scan.header, dcTables, acTables, scan.restartInterval, section),
-            "Unable to decode RST segment");
-        mcus.insert(mcus.end(), decodedSection.begin(), decodedSection.end());
+auto FileParser::Jpeg::Decoder::decodeScan(
+    const FrameInfo& frame,
+    const Scan& scan,
+    const std::span<const uint8_t> fileBytes,
+    const HuffmanTablePtrs& dcTables,
+    const HuffmanTablePtrs& acTables,
+    const DequantizationTables& dequantizationTables,
+    const DecodeScale scale,
+    const bool lumaOnly,
+    const size_t chunkCount
+) -> std::expected<std::vector<CoefficientPlane>, std::string> {
+    const size_t totalMcus   = static_cast<size_t>(frame.mcuWidth) * frame.mcuHeight;
+    const size_t sectionMcus = scan.restartInterval != 0 ? scan.restartInterval : totalMcus;
+    ASSIGN_OR_PROPAGATE(expectedSections, countDataSections(frame, scan));
+
+    auto planes = createPlanes(frame, frame.mcuHeight, lumaOnly);
+    const auto layout = getMcuLayout(frame, scan.header, scale, lumaOnly);
+    auto getSectionBytes = [&](const size_t sectionIndex) {
+        return fileBytes.subspan(scan.dataSections[sectionIndex].offset, scan.dataSections[sectionIndex].length);
+    };
+
+    // Without restart markers there is nothing to split on, so split the data at guessed positions instead
+    if (expectedSections == 1 && chunkCount > 1) {
+        CHECK_VOID_AND_RETURN(
+            decodeSpeculatively(
+                planes, frame, scan.header, layout, dcTables, acTables, dequantizationTables, getSectionBytes(0), chunkCount),
+            "Unable to decode scan data");
+        return planes;
     }
 
-    return mcus;
+    std::vector<std::optional<std::string>> errors(expectedSections);
+
+    ThreadPool::shared().parallelFor(expectedSections, [&](const size_t sectionIndex) {
+        const size_t firstMcu = sectionIndex * sectionMcus;
+        const size_t mcuCount = std::min(sectionMcus, totalMcus - firstMcu);
+        const auto result = decodeRSTSegment(
+            planes, firstMcu, mcuCount, frame, scan.header, layout, dcTables, acTables, dequantizationTables,
+            getSectionBytes(sectionIndex));
+        if (!result) {
+            errors[sectionIndex] = std::format("Unable to decode RST segment {}: {}", sectionIndex, result.error());
+        }
+    });
+
+    // Report the earliest failing segment so errors are the same regardless of scheduling
+    for (const auto& error : errors) {
+        if (error) {
+            return std::unexpected(*error);
+        }
+    }
+    return planes;
 }
 
 namespace {
@@ -626,24 +1194,380 @@ namespace {
         }
         return result;
     }
+
+    // The region to decode, which is the whole image when the options have none
+    auto resolveRegion(
+        const FileParser::Jpeg::DecodeOptions& options, const size_t width, const size_t height
+    ) -> std::expected<FileParser::Jpeg::Region, std::string> {
+        if (!options.region) {
+            return FileParser::Jpeg::Region{ .width = static_cast<uint32_t>(width), .height = static_cast<uint32_t>(height) };
+        }
+        const auto& region = *options.region;
+        if (region.width == 0 || region.height == 0) {
+            return std::unexpected("Region is empty");
+        }
+        if (static_cast<size_t>(region.x) + region.width > width || static_cast<size_t>(region.y) + region.height > height) {
+            return std::unexpected(std::format("Region of {}x{} at ({}, {}) does not fit in the {}x{} image",
+                region.width, region.height, region.x, region.y, width, height));
+        }
+        return region;
+    }
+
+    // Checks that output can hold a decoded image of width x height in format
+    auto checkOutputBuffer(
+        const FileParser::Jpeg::OutputBuffer& output, const size_t width, const size_t height, const FileParser::PixelFormat format
+    ) -> std::expected<void, std::string> {
+        const size_t rowBytes = width * FileParser::getBytesPerPixel(format);
+        if (output.data == nullptr) {
+            return std::unexpected("Output buffer is null");
+        }
+        if (output.stride < rowBytes) {
+            return std::unexpected(std::format("Output stride of {} bytes is less than the {} bytes of a row", output.stride, rowBytes));
+        }
+        if (output.size < rowBytes || (output.size - rowBytes) / output.stride < height - 1) {
+            return std::unexpected(std::format("Output buffer of {} bytes is too small for a {}x{} image with a stride of {} bytes",
+                output.size, width, height, output.stride));
+        }
+        return {};
+    }
+}
+
+auto FileParser::Jpeg::Decoder::decodeIntoBuffer(
+    const JpegData& data,
+    const std::span<const uint8_t> bytes,
+    const OutputBuffer& output,
+    const DecodeOptions& options
+) -> std::expected<void, std::string> {
+    if (options.region) {
+        // Only the MCU rows of the region are needed, which is exactly what the row decoder does
+        return decodeRegionRows(data, bytes, output, options);
+    }
+
+    const auto [quantizationTables, acTables, dcTables] = resolveTableIterations(
+        data.scans[0].iterations, data.quantizationTables, data.huffmanTables);
+
+    ASSIGN_OR_RETURN(dequantizationTables, createDequantizationTables(data.frameInfo, data.scans[0].header, quantizationTables),
+                     "Unable to decode scan");
+    const bool lumaOnly = options.format == PixelFormat::Gray8;
+    ASSIGN_OR_RETURN(planes, decodeScan(data.frameInfo, data.scans[0], bytes, dcTables, acTables, dequantizationTables,
+                                        options.scale, lumaOnly),
+                     "Unable to decode scan");
+    CHECK_VOID_AND_RETURN(convertPlanesToPixels(planes, data.frameInfo, options.scale, options.upsampling, options.format, output),
+                          "Unable to convert scan to pixels");
+    return {};
 }
 
 auto FileParser::Jpeg::Decoder::decode(
-    const std::filesystem::path& filePath
+    const std::span<const uint8_t> bytes,
+    const DecodeOptions& options
 ) -> std::expected<Image, std::string> {
-    ASSIGN_OR_PROPAGATE(data, Parser::parseFile(filePath));
-    const size_t width  = data.frameInfo.header.numberOfSamplesPerLine;
-    const size_t height = data.frameInfo.header.numberOfLines;
+    ASSIGN_OR_PROPAGATE(data, Parser::parse(bytes));
+    const size_t width  = getScaledSize(data.frameInfo.header.numberOfSamplesPerLine, options.scale);
+    const size_t height = getScaledSize(data.frameInfo.header.numberOfLines, options.scale);
+    ASSIGN_OR_PROPAGATE(region, resolveRegion(options, width, height));
+
+    const size_t rowBytes = static_cast<size_t>(region.width) * getBytesPerPixel(options.format);
+    std::vector<uint8_t> pixels(rowBytes * region.height);
+    const OutputBuffer output{ .data = pixels.data(), .stride = rowBytes, .size = pixels.size() };
+    CHECK_VOID_OR_PROPAGATE(decodeIntoBuffer(data, bytes, output, options));
+    return Image(region.width, region.height, std::move(pixels), options.format);
+}
+
+auto FileParser::Jpeg::Decoder::decode(
+    const std::filesystem::path& filePath,
+    const DecodeOptions& options
+) -> std::expected<Image, std::string> {
+    ASSIGN_OR_PROPAGATE(bytes, FileUtils::readFileBytes(filePath));
+    return decode(bytes, options);
+}
 
+auto FileParser::Jpeg::Decoder::decodeInto(
+    const std::span<const uint8_t> bytes,
+    const OutputBuffer& output,
+    const DecodeOptions& options
+) -> std::expected<void, std::string> {
+    ASSIGN_OR_PROPAGATE(data, Parser::parse(bytes));
+    const size_t width  = getScaledSize(data.frameInfo.header.numberOfSamplesPerLine, options.scale);
+    const size_t height = getScaledSize(data.frameInfo.header.numberOfLines, options.scale);
+    ASSIGN_OR_PROPAGATE(region, resolveRegion(options, width, height));
+    CHECK_VOID_OR_PROPAGATE(checkOutputBuffer(output, region.width, region.height, options.format));
+    return decodeIntoBuffer(data, bytes, output, options);
+}
+
+auto FileParser::Jpeg::Decoder::decodeRows(
+    const std::span<const uint8_t> bytes,
+    const ScanlineSink& sink,
+    const DecodeOptions& options
+) -> std::expected<void, std::string> {
+    ASSIGN_OR_PROPAGATE(data, Parser::parse(bytes));
+    return decodeRegionRows(data, bytes, &sink, options);
+}
+
+auto FileParser::Jpeg::Decoder::decodePlanar(
+    const std::span<const uint8_t> bytes,
+    const DecodeOptions& options
+) -> std::expected<YCbCrImage, std::string> {
+    if (options.region) {
+        return std::unexpected("Planar decoding does not support regions");
+    }
+    ASSIGN_OR_PROPAGATE(data, Parser::parse(bytes));
     const auto [quantizationTables, acTables, dcTables] = resolveTableIterations(
         data.scans[0].iterations, data.quantizationTables, data.huffmanTables);
 
-    ASSIGN_OR_RETURN_MUT(mcus, decodeScan(data.frameInfo, data.scans[0], dcTables, acTables), "Unable to decode scan");
-    for (auto& mcu: mcus) {
-        CHECK_VOID_AND_RETURN(dequantize(mcu, data.frameInfo, data.scans[0].header, quantizationTables), "Unable to dequantize scan");
-        inverseDCT(mcu);
+    ASSIGN_OR_RETURN(dequantizationTables, createDequantizationTables(data.frameInfo, data.scans[0].header, quantizationTables),
+                     "Unable to decode scan");
+    ASSIGN_OR_RETURN(planes, decodeScan(data.frameInfo, data.scans[0], bytes, dcTables, acTables, dequantizationTables, options.scale),
+                     "Unable to decode scan");
+    return convertPlanesToYCbCr(planes, data.frameInfo, options.scale);
+}
+
+auto FileParser::Jpeg::Decoder::decodeCoefficients(
+    const std::span<const uint8_t> bytes
+) -> std::expected<CoefficientImage, std::string> {
+    ASSIGN_OR_PROPAGATE(data, Parser::parse(bytes));
+    const auto& frame = data.frameInfo;
+    const auto& scan  = data.scans[0];
+    const auto [quantizationTables, acTables, dcTables] = resolveTableIterations(
+        scan.iterations, data.quantizationTables, data.huffmanTables);
+
+    // Multiplying by 1 leaves every coefficient quantized
+    DequantizationTables identityTables;
+    for (auto& table : identityTables) {
+        table.multipliers.fill(1);
     }
+    ASSIGN_OR_RETURN_MUT(planes, decodeScan(frame, scan, bytes, dcTables, acTables, identityTables), "Unable to decode scan");
+
+    CoefficientImage image{
+        .frameHeader     = frame.header,
+        .mcuWidth        = frame.mcuWidth,
+        .mcuHeight       = frame.mcuHeight,
+        .restartInterval = scan.restartInterval,
+        .components      = {}
+    };
+    image.components.reserve(frame.header.components.size());
+    for (size_t i = 0; i < frame.header.components.size(); i++) {
+        const auto& component = frame.header.components[i];
+        const auto scanComp = std::ranges::find_if(scan.header.components, [&](const ScanComponent& c) {
+            return c.componentSelector == component.identifier;
+        });
+        if (scanComp == scan.header.components.end()) {
+            return std::unexpected(std::format("Component {} is not in the first scan", component.identifier));
+        }
+        const QuantizationTable* quantizationTable = quantizationTables[component.quantizationTableSelector];
+        if (quantizationTable == nullptr) {
+            return std::unexpected("Quantization table was undefined");
+        }
+        image.components.push_back({
+            .component         = component,
+            .quantizationTable = *quantizationTable,
+            .dcTable           = *dcTables[scanComp->dcTableSelector],
+            .acTable           = *acTables[scanComp->acTableSelector],
+            .plane             = std::move(planes[i])
+        });
+    }
+    return image;
+}
 
-    std::vector<uint8_t> rgbData = getRawRGBData(convertMcusToColorBlocks(mcus, width, height), width, height);
-    return Image(static_cast<uint32_t>(width), static_cast<uint32_t>(height), std::move(rgbData));
+auto FileParser::Jpeg::Decoder::checkSpeculativeDecode(
+    const std::span<const uint8_t> bytes,
+    const size_t chunkCount
+) -> std::expected<void, std::string> {
+    if (chunkCount < 2) {
+        return std::unexpected("Speculative decoding needs at least 2 chunks");
+    }
+    ASSIGN_OR_PROPAGATE(data, Parser::parse(bytes));
+    const auto& frame = data.frameInfo;
+    const auto& scan  = data.scans[0];
+    ASSIGN_OR_PROPAGATE(sectionCount, countDataSections(frame, scan));
+    if (sectionCount != 1) {
+        return std::unexpected("Scan has restart markers, so it is never decoded speculatively");
+    }
+    const auto [quantizationTables, acTables, dcTables] = resolveTableIterations(
+        scan.iterations, data.quantizationTables, data.huffmanTables);
+    ASSIGN_OR_RETURN(dequantizationTables, createDequantizationTables(frame, scan.header, quantizationTables), "Unable to decode scan");
+
+    ASSIGN_OR_RETURN(serial, decodeScan(frame, scan, bytes, dcTables, acTables, dequantizationTables, DecodeScale::Full, false, 1),
+                     "Unable to decode scan serially");
+    ASSIGN_OR_RETURN(speculative, decodeScan(frame, scan, bytes, dcTables, acTables, dequantizationTables, DecodeScale::Full, false,
+                                             chunkCount),
+                     "Unable to decode scan speculatively");
+    for (size_t planeIndex = 0; planeIndex < serial.size(); planeIndex++) {
+        const auto& expected = serial[planeIndex];
+        const auto& actual   = speculative[planeIndex];
+        for (size_t row = 0; row < expected.getBlockLines(); row++) {
+            for (size_t col = 0; col < expected.getBlocksPerLine(); col++) {
+                if (expected.getBlock(row, col).coefficients != actual.getBlock(row, col).coefficients ||
+                    expected.getLastNonzero(row, col) != actual.getLastNonzero(row, col)) {
+                    return std::unexpected(std::format("Component {} differs at block row {}, column {}", planeIndex, row, col));
+                }
+            }
+        }
+    }
+    return {};
+}
+
+auto FileParser::Jpeg::Decoder::decodeRegionRows(
+    const JpegData& data,
+    const std::span<const uint8_t> bytes,
+    const RowOutput& output,
+    const DecodeOptions& options
+) -> std::expected<void, std::string> {
+    const auto& frame = data.frameInfo;
+    const auto& scan  = data.scans[0];
+    const auto [quantizationTables, acTables, dcTables] = resolveTableIterations(
+        scan.iterations, data.quantizationTables, data.huffmanTables);
+
+    const size_t totalMcus   = static_cast<size_t>(frame.mcuWidth) * frame.mcuHeight;
+    const size_t sectionMcus = scan.restartInterval != 0 ? scan.restartInterval : totalMcus;
+    ASSIGN_OR_RETURN(sectionCount, countDataSections(frame, scan), "Unable to decode scan");
+    ASSIGN_OR_RETURN(dequantizationTables, createDequantizationTables(frame, scan.header, quantizationTables), "Unable to decode scan");
+
+    const size_t channels    = getBytesPerPixel(options.format);
+    const size_t pixelWidth  = getScaledSize(frame.header.numberOfSamplesPerLine, options.scale);
+    const size_t pixelHeight = getScaledSize(frame.header.numberOfLines, options.scale);
+    const McuGeometry geometry = getMcuGeometry(frame, options.scale);
+    ASSIGN_OR_PROPAGATE(region, resolveRegion(options, pixelWidth, pixelHeight));
+
+    // The MCUs the region touches, as half-open ranges of rows and columns
+    const size_t firstMcuRow = region.y / geometry.height;
+    const size_t endMcuRow   = (region.y + region.height - 1) / geometry.height + 1;
+    const size_t firstMcuCol = region.x / geometry.width;
+    const size_t endMcuCol   = (region.x + region.width - 1) / geometry.width + 1;
+
+    // Fancy upsampling also reads chroma from the MCUs around the region, so those are decoded too. An MCU row is then
+    // only converted once the row below it is decoded
+    const bool   lumaOnly    = options.format == PixelFormat::Gray8;
+    const size_t contextRows = !lumaOnly && needsNeighbourRows(geometry, options.upsampling) ? 1 : 0;
+    const size_t contextCols = !lumaOnly && needsNeighbourColumns(geometry, options.upsampling) ? 1 : 0;
+    const size_t decodeFirstRow = firstMcuRow - std::min(firstMcuRow, contextRows);
+    const size_t decodeEndRow   = std::min<size_t>(endMcuRow + contextRows, frame.mcuHeight);
+    const size_t decodeFirstCol = firstMcuCol - std::min(firstMcuCol, contextCols);
+    const size_t decodeEndCol   = std::min<size_t>(endMcuCol + contextCols, frame.mcuWidth);
+    auto isDecoded = [&](const size_t mcuIndex) {
+        const size_t mcuRow = mcuIndex / frame.mcuWidth;
+        const size_t mcuCol = mcuIndex % frame.mcuWidth;
+        return mcuRow >= decodeFirstRow && mcuRow < decodeEndRow && mcuCol >= decodeFirstCol && mcuCol < decodeEndCol;
+    };
+    // Restart intervals reset the DC predictors, so one without any MCU to decode can be skipped entirely
+    auto touchesRegion = [&](const size_t firstMcu, const size_t mcuCount) {
+        const size_t lastMcu = firstMcu + mcuCount - 1;
+        const size_t lastRow = std::min(lastMcu / frame.mcuWidth, decodeEndRow - 1);
+        for (size_t mcuRow = std::max(firstMcu / frame.mcuWidth, decodeFirstRow); mcuRow <= lastRow; mcuRow++) {
+            const size_t rowStart = std::max(firstMcu, mcuRow * frame.mcuWidth);
+            const size_t rowEnd   = std::min(lastMcu + 1, (mcuRow + 1) * frame.mcuWidth);
+            if (rowStart % frame.mcuWidth < decodeEndCol && (rowEnd - 1) % frame.mcuWidth >= decodeFirstCol) {
+                return true;
+            }
+        }
+        return false;
+    };
+
+    // MCU rows of coefficients are reused in turn: one, or three when rows need the rows either side of them
+    const size_t planeRowCount = 1 + 2 * contextRows;
+    auto planes = createPlanes(frame, planeRowCount, lumaOnly);
+    const auto layout = getMcuLayout(frame, scan.header, options.scale, lumaOnly);
+    const size_t rowBytes = static_cast<size_t>(region.width) * channels;
+    const auto* buffer = std::get_if<OutputBuffer>(&output);
+    std::vector<uint8_t> pixelRows(buffer == nullptr ? rowBytes * geometry.height : 0);
+    auto scratch = createMcuRowScratch(frame, options.scale, options.upsampling, options.format, region);
+
+    auto emitMcuRow = [&](const size_t mcuRow) -> std::expected<void, std::string> {
+        PlaneRows planeRows;
+        planeRows.current = mcuRow % planeRowCount;
+        if (contextRows != 0 && mcuRow > 0)                   planeRows.above = (mcuRow - 1) % planeRowCount;
+        if (contextRows != 0 && mcuRow + 1 < frame.mcuHeight) planeRows.below = (mcuRow + 1) % planeRowCount;
+        const size_t firstRow = std::max<size_t>(mcuRow * geometry.height, region.y);
+        const size_t endRow   = std::min<size_t>((mcuRow + 1) * geometry.height, region.y + region.height);
+
+        if (buffer != nullptr) {
+            const size_t offset = (firstRow - region.y) * buffer->stride;
+            CHECK_VOID_AND_RETURN(convertMcuRowToPixels(planes, frame, options.scale, options.upsampling, options.format, planeRows,
+                                                        mcuRow, region, std::span(buffer->data + offset, buffer->size - offset), buffer->stride,
+                                                        scratch),
+                                  "Unable to convert scan to pixels");
+            return {};
+        }
+        CHECK_VOID_AND_RETURN(convertMcuRowToPixels(planes, frame, options.scale, options.upsampling, options.format, planeRows,
+                                                    mcuRow, region, pixelRows, rowBytes, scratch),
+                              "Unable to convert scan to pixels");
+        const auto& sink = *std::get<const ScanlineSink*>(output);
+        for (size_t row = firstRow; row < endRow; row++) {
+            sink(row - region.y, std::span<const uint8_t>(pixelRows).subspan((row - firstRow) * rowBytes, rowBytes));
+        }
+        return {};
+    };
+
+    // How far decoding has got through a restart interval
+    struct SegmentCursor {
+        BitReader bitReader;
+        PreviousDC prevDc{};
+        size_t decodedMcus = 0;
+    };
+    // Decodes a restart interval from the cursor on, with the same errors as decodeRSTSegment. Stops once an MCU row has
+    // every column that is decoded, since that row may be ready to emit, and returns it
+    auto decodeSegment = [&](SegmentCursor& cursor, const size_t firstMcu, const size_t mcuCount)
+        -> std::expected<std::optional<size_t>, std::string> {
+        while (cursor.decodedMcus < mcuCount) {
+            const size_t i        = cursor.decodedMcus++;
+            const size_t mcuIndex = firstMcu + i;
+            const size_t mcuRow   = mcuIndex / frame.mcuWidth;
+            const size_t mcuCol   = mcuIndex % frame.mcuWidth;
+            const auto result = isDecoded(mcuIndex)
+                ? decodeMcu(planes, mcuRow % planeRowCount * frame.mcuWidth + mcuCol, cursor.bitReader, frame, scan.header, layout,
+                            dcTables, acTables, dequantizationTables, cursor.prevDc)
+                : skipMcu(cursor.bitReader, scan.header, layout, dcTables, acTables, cursor.prevDc);
+            if (!result) {
+                return std::unexpected(std::format("Unable to decode MCU {}: {}", i, toString(result.error())));
+            }
+            // The rest of an MCU row is not needed, so the row is finished once its last decoded column is
+            if (isDecoded(mcuIndex) && mcuCol == decodeEndCol - 1) {
+                return mcuRow;
+            }
+        }
+        CHECK_VOID_OR_PROPAGATE(finishRSTSegment(cursor.bitReader));
+        return std::nullopt;
+    };
+    // Reports errors with the segment, as decodeScan does
+    auto decodeSegmentOf = [&](SegmentCursor& cursor, const size_t sectionIndex, const size_t firstMcu, const size_t mcuCount)
+        -> std::expected<std::optional<size_t>, std::string> {
+        ASSIGN_OR_RETURN(finishedRow, decodeSegment(cursor, firstMcu, mcuCount), std::format("Unable to decode RST segment {}", sectionIndex));
+        return finishedRow;
+    };
+
+    for (size_t sectionIndex = 0; sectionIndex < sectionCount; sectionIndex++) {
+        const size_t firstMcu = sectionIndex * sectionMcus;
+        const size_t mcuCount = std::min(sectionMcus, totalMcus - firstMcu);
+        if (!touchesRegion(firstMcu, mcuCount)) {
+            continue;
+        }
+
+        const auto& section = scan.dataSections[sectionIndex];
+        SegmentCursor cursor{.bitReader = BitReader{bytes.subspan(section.offset, section.length)}};
+        while (true) {
+            ASSIGN_OR_RETURN(finishedRow, decodeSegmentOf(cursor, sectionIndex, firstMcu, mcuCount), "Unable to decode scan");
+            if (!finishedRow) {
+                break;
+            }
+            const size_t mcuRow = *finishedRow;
+            if (mcuRow < contextRows) {
+                continue;
+            }
+            if (const size_t readyRow = mcuRow - contextRows; readyRow >= firstMcuRow && readyRow < endMcuRow) {
+                CHECK_VOID_OR_PROPAGATE(emitMcuRow(readyRow));
+                if (readyRow == endMcuRow - 1 && firstMcu + cursor.decodedMcus < totalMcus) {
+                    return {}; // Nothing after the region is needed
+                }
+            }
+            // The planes of the next row held the row that is no longer needed by any other
+            for (auto& plane : planes) {
+                const size_t linesPerRow = plane.getBlockLines() / planeRowCount;
+                plane.clearBlockLines((mcuRow + 1) % planeRowCount * linesPerRow, linesPerRow);
+            }
+        }
+    }
+    // The last MCU row has no row below it to wait for
+    if (contextRows != 0 && endMcuRow == frame.mcuHeight) {
+        CHECK_VOID_OR_PROPAGATE(emitMcuRow(endMcuRow - 1));
+    }
+    return {};
 }
@@ -1,33 +1,34 @@
 #include "FileParser/Jpeg/HuffmanBuilder.hpp"
 
 #include <array>
+#include <format>
 #include <numeric>
 
-#include "FileParser/BitManipulationUtil.h"
-#include "FileParser/Utils.hpp"
+#include "FileParser/Macros.hpp"
 
-auto FileParser::Jpeg::HuffmanBuilder::readFromFile(
-    std::ifstream& file
+auto FileParser::Jpeg::HuffmanBuilder::readFromBytes(
+    IO::ByteSpanReader& reader
 ) -> std::expected<HuffmanTable, std::string> {
     // Read num of each encoding
-    const auto codeSizesExpected = read_uint8(file, HuffmanTable::maxEncodingLength);
-    if (!codeSizesExpected) {
-        return utils::getUnexpected(codeSizesExpected, "Unable to parse code sizes");
-    }
-    if (codeSizesExpected->size() != HuffmanTable::maxEncodingLength) {
-        return std::unexpected("Incorrect number of code sizes");
-    }
     std::array<uint8_t, HuffmanTable::maxEncodingLength> codeSizes{};
-    std::ranges::copy(codeSizesExpected->begin(), codeSizesExpected->end(), codeSizes.begin());
+    BYTEREADER_CALL_VOID_OR_RETURN(reader, read_into(codeSizes.data(), codeSizes.size()), std::unexpected("Unable to parse code sizes"));
 
     // Read symbols
-    const int symbolCount = std::accumulate(codeSizes.begin(), codeSizes.end(), 0);
-    const auto symbols = read_uint8(file, symbolCount);
-    if (!symbols) {
-        return utils::getUnexpected(symbols, "Unable to parse symbols");
+    const size_t symbolCount = std::accumulate(codeSizes.begin(), codeSizes.end(), size_t{0});
+    std::vector<uint8_t> symbols(symbolCount);
+    BYTEREADER_CALL_VOID_OR_RETURN(reader, read_into(symbols.data(), symbols.size()), std::unexpected("Unable to parse symbols"));
+
+    // Canonical codes of each length follow on from the shorter ones, so a length can run out of codes to hand out
+    uint32_t nextCode = 0;
+    for (size_t i = 0; i < codeSizes.size(); i++) {
+        nextCode += codeSizes[i];
+        if (nextCode > uint32_t{1} << (i + 1)) {
+            return std::unexpected(std::format("Too many Huffman codes of length {}", i + 1));
+        }
+        nextCode <<= 1;
     }
 
-    const std::vector<HuffmanEncoding> encodings = generateEncodings(*symbols, codeSizes);
+    const std::vector<HuffmanEncoding> encodings = generateEncodings(symbols, codeSizes);
     return HuffmanTable(encodings);
 }
 
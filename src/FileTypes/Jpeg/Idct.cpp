@@ -0,0 +1,278 @@
+#include "FileParser/Jpeg/Idct.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+
+#include <simde/x86/sse2.h>
+
+namespace {
+    // Constants are 13-bit fixed point, and pass 1 keeps 2 extra fractional bits for pass 2
+    constexpr int constBits = 13;
+    constexpr int pass1Bits = 2;
+    constexpr int16_t fix0_298 =  2446; // 0.298631336
+    constexpr int16_t fix0_390 =  3196; // 0.390180644
+    constexpr int16_t fix0_541 =  4433; // 0.541196100
+    constexpr int16_t fix0_765 =  6270; // 0.765366865
+    constexpr int16_t fix0_899 =  7373; // 0.899976223
+    constexpr int16_t fix1_175 =  9633; // 1.175875602
+    constexpr int16_t fix1_501 = 12299; // 1.501321110
+    constexpr int16_t fix1_847 = 15137; // 1.847759065
+    constexpr int16_t fix1_961 = 16069; // 1.961570560
+    constexpr int16_t fix2_053 = 16819; // 2.053119869
+    constexpr int16_t fix2_562 = 20995; // 2.562915447
+    constexpr int16_t fix3_072 = 25172; // 3.072711026
+
+    using Rows = simde__m128i[8];
+
+    // Eight 32-bit intermediates, split across two registers
+    struct Wide {
+        simde__m128i low;
+        simde__m128i high;
+    };
+
+    auto add(const Wide& a, const Wide& b) -> Wide {
+        return { simde_mm_add_epi32(a.low, b.low), simde_mm_add_epi32(a.high, b.high) };
+    }
+
+    auto sub(const Wide& a, const Wide& b) -> Wide {
+        return { simde_mm_sub_epi32(a.low, b.low), simde_mm_sub_epi32(a.high, b.high) };
+    }
+
+    // a * c0 + b * c1 in 32 bits, for each of the eight lanes
+    auto multiplyAdd(const simde__m128i a, const simde__m128i b, const int16_t c0, const int16_t c1) -> Wide {
+        const simde__m128i constants = simde_mm_set_epi16(c1, c0, c1, c0, c1, c0, c1, c0);
+        return {
+            simde_mm_madd_epi16(simde_mm_unpacklo_epi16(a, b), constants),
+            simde_mm_madd_epi16(simde_mm_unpackhi_epi16(a, b), constants)
+        };
+    }
+
+    // Rounds away the given number of bits and narrows back to 16 bits, saturating
+    template <int Bits>
+    auto descale(const Wide& value) -> simde__m128i {
+        const simde__m128i rounding = simde_mm_set1_epi32(1 << (Bits - 1));
+        return simde_mm_packs_epi32(
+            simde_mm_srai_epi32(simde_mm_add_epi32(value.low,  rounding), Bits),
+            simde_mm_srai_epi32(simde_mm_add_epi32(value.high, rounding), Bits));
+    }
+
+    /**
+     * @brief One dimensional IDCT of eight lanes at once, the same factorisation as the libjpeg "islow" IDCT.
+     *
+     * v[k] holds frequency k and is replaced by sample k. The rotations are rearranged into pairs of products so each
+     * pair is a single madd.
+     */
+    template <int DescaleBits>
+    auto idctPass(Rows& v) -> void {
+        // Even part
+        const Wide even3 = multiplyAdd(v[2], v[6], fix0_541 + fix0_765, fix0_541);
+        const Wide even2 = multiplyAdd(v[2], v[6], fix0_541, fix0_541 - fix1_847);
+        const Wide even0 = multiplyAdd(v[0], v[4], 1 << constBits,  1 << constBits);
+        const Wide even1 = multiplyAdd(v[0], v[4], 1 << constBits, -(1 << constBits));
+
+        const Wide tmp10 = add(even0, even3);
+        const Wide tmp13 = sub(even0, even3);
+        const Wide tmp11 = add(even1, even2);
+        const Wide tmp12 = sub(even1, even2);
+
+        // Odd part
+        const simde__m128i z3 = simde_mm_add_epi16(v[7], v[3]);
+        const simde__m128i z4 = simde_mm_add_epi16(v[5], v[1]);
+        const Wide z3Rotated = multiplyAdd(z3, z4, fix1_175 - fix1_961, fix1_175);
+        const Wide z4Rotated = multiplyAdd(z3, z4, fix1_175, fix1_175 - fix0_390);
+
+        const Wide odd0 = add(multiplyAdd(v[7], v[1], fix0_298 - fix0_899, -fix0_899), z3Rotated);
+        const Wide odd3 = add(multiplyAdd(v[7], v[1], -fix0_899, fix1_501 - fix0_899), z4Rotated);
+        const Wide odd1 = add(multiplyAdd(v[5], v[3], fix2_053 - fix2_562, -fix2_562), z4Rotated);
+        const Wide odd2 = add(multiplyAdd(v[5], v[3], -fix2_562, fix3_072 - fix2_562), z3Rotated);
+
+        v[0] = descale<DescaleBits>(add(tmp10, odd3));
+        v[7] = descale<DescaleBits>(sub(tmp10, odd3));
+        v[1] = descale<DescaleBits>(add(tmp11, odd2));
+        v[6] = descale<DescaleBits>(sub(tmp11, odd2));
+        v[2] = descale<DescaleBits>(add(tmp12, odd1));
+        v[5] = descale<DescaleBits>(sub(tmp12, odd1));
+        v[3] = descale<DescaleBits>(add(tmp13, odd0));
+        v[4] = descale<DescaleBits>(sub(tmp13, odd0));
+    }
+
+    /**
+     * @brief idctPass for when v[4] to v[7] are zero, giving the same results.
+     *
+     * With those inputs gone every output is one pair of products of v[0] and v[2] or of v[1] and v[3], so the
+     * constants below are sums of the ones idctPass uses.
+     */
+    template <int DescaleBits>
+    auto idctPassLowFrequency(Rows& v) -> void {
+        const Wide tmp10 = multiplyAdd(v[0], v[2], 1 << constBits,  fix0_541 + fix0_765);
+        const Wide tmp11 = multiplyAdd(v[0], v[2], 1 << constBits,  fix0_541);
+        const Wide tmp12 = multiplyAdd(v[0], v[2], 1 << constBits, -fix0_541);
+        const Wide tmp13 = multiplyAdd(v[0], v[2], 1 << constBits, -fix0_541 - fix0_765);
+
+        const Wide odd0 = multiplyAdd(v[1], v[3], fix1_175 - fix0_899, fix1_175 - fix1_961);
+        const Wide odd1 = multiplyAdd(v[1], v[3], fix1_175 - fix0_390, fix1_175 - fix2_562);
+        const Wide odd2 = multiplyAdd(v[1], v[3], fix1_175, fix3_072 - fix2_562 + fix1_175 - fix1_961);
+        const Wide odd3 = multiplyAdd(v[1], v[3], fix1_501 - fix0_899 + fix1_175 - fix0_390, fix1_175);
+
+        v[0] = descale<DescaleBits>(add(tmp10, odd3));
+        v[7] = descale<DescaleBits>(sub(tmp10, odd3));
+        v[1] = descale<DescaleBits>(add(tmp11, odd2));
+        v[6] = descale<DescaleBits>(sub(tmp11, odd2));
+        v[2] = descale<DescaleBits>(add(tmp12, odd1));
+        v[5] = descale<DescaleBits>(sub(tmp12, odd1));
+        v[3] = descale<DescaleBits>(add(tmp13, odd0));
+        v[4] = descale<DescaleBits>(sub(tmp13, odd0));
+    }
+
+    auto transpose(Rows& v) -> void {
+        const simde__m128i a0 = simde_mm_unpacklo_epi16(v[0], v[1]);
+        const simde__m128i a1 = simde_mm_unpackhi_epi16(v[0], v[1]);
+        const simde__m128i a2 = simde_mm_unpacklo_epi16(v[2], v[3]);
+        const simde__m128i a3 = simde_mm_unpackhi_epi16(v[2], v[3]);
+        const simde__m128i a4 = simde_mm_unpacklo_epi16(v[4], v[5]);
+        const simde__m128i a5 = simde_mm_unpackhi_epi16(v[4], v[5]);
+        const simde__m128i a6 = simde_mm_unpacklo_epi16(v[6], v[7]);
+        const simde__m128i a7 = simde_mm_unpackhi_epi16(v[6], v[7]);
+
+        const simde__m128i b0 = simde_mm_unpacklo_epi32(a0, a2);
+        const simde__m128i b1 = simde_mm_unpackhi_epi32(a0, a2);
+        const simde__m128i b2 = simde_mm_unpacklo_epi32(a1, a3);
+        const simde__m128i b3 = simde_mm_unpackhi_epi32(a1, a3);
+        const simde__m128i b4 = simde_mm_unpacklo_epi32(a4, a6);
+        const simde__m128i b5 = simde_mm_unpackhi_epi32(a4, a6);
+        const simde__m128i b6 = simde_mm_unpacklo_epi32(a5, a7);
+        const simde__m128i b7 = simde_mm_unpackhi_epi32(a5, a7);
+
+        v[0] = simde_mm_unpacklo_epi64(b0, b4);
+        v[1] = simde_mm_unpackhi_epi64(b0, b4);
+        v[2] = simde_mm_unpacklo_epi64(b1, b5);
+        v[3] = simde_mm_unpackhi_epi64(b1, b5);
+        v[4] = simde_mm_unpacklo_epi64(b2, b6);
+        v[5] = simde_mm_unpackhi_epi64(b2, b6);
+        v[6] = simde_mm_unpacklo_epi64(b3, b7);
+        v[7] = simde_mm_unpackhi_epi64(b3, b7);
+    }
+
+    auto descale(const int32_t value, const int bits) -> int32_t {
+        return (value + (1 << (bits - 1))) >> bits;
+    }
+
+    auto clampToInt16(const int32_t value) -> int32_t {
+        return std::clamp<int32_t>(value, std::numeric_limits<int16_t>::min(), std::numeric_limits<int16_t>::max());
+    }
+
+    // Level shifts a sample and clamps it to [0, 255]
+    auto toSample(const int32_t value) -> uint8_t {
+        return static_cast<uint8_t>(std::clamp(value + 128, 0, 255));
+    }
+
+    // The scaled transforms below are the 4 and 2 point IDCTs, which is what the 8 point IDCT becomes once each output
+    // covers several samples and only the frequencies that can be represented at that size are kept
+    auto inverseDCT4x4(const FileParser::Jpeg::CoefficientBlock& block, uint8_t* out, const size_t stride) -> void {
+        constexpr int32_t fix0_382 = 3135; // cos(3 * pi / 8)
+        constexpr int32_t fix0_707 = 5793; // cos(pi / 4)
+        constexpr int32_t fix0_923 = 7568; // cos(pi / 8)
+
+        // Both passes also halve, the scale factor of each 1 dimensional IDCT
+        std::array<int32_t, 16> workspace{};
+        auto pass = [](const int32_t in0, const int32_t in1, const int32_t in2, const int32_t in3, const int bits,
+                       const auto& store) {
+            const int32_t even0 = (in0 + in2) * fix0_707;
+            const int32_t even1 = (in0 - in2) * fix0_707;
+            const int32_t odd0  = in1 * fix0_923 + in3 * fix0_382;
+            const int32_t odd1  = in1 * fix0_382 - in3 * fix0_923;
+            store(0, descale(even0 + odd0, bits));
+            store(1, descale(even1 + odd1, bits));
+            store(2, descale(even1 - odd1, bits));
+            store(3, descale(even0 - odd0, bits));
+        };
+        for (size_t col = 0; col < 4; col++) {
+            pass(block[col], block[8 + col], block[16 + col], block[24 + col], constBits + 1 - pass1Bits,
+                 [&](const size_t row, const int32_t value) { workspace[row * 4 + col] = clampToInt16(value); });
+        }
+        for (size_t row = 0; row < 4; row++) {
+            const int32_t* in = &workspace[row * 4];
+            pass(in[0], in[1], in[2], in[3], constBits + 1 + pass1Bits,
+                 [&](const size_t col, const int32_t value) { out[row * stride + col] = toSample(value); });
+        }
+    }
+
+    // Both 2 point passes are sums and differences scaled by 1 / (2 * sqrt(2)), so the whole transform is exact
+    auto inverseDCT2x2(const FileParser::Jpeg::CoefficientBlock& block, uint8_t* out, const size_t stride) -> void {
+        const int32_t top0 = block[0] + block[1];
+        const int32_t top1 = block[0] - block[1];
+        const int32_t bottom0 = block[8] + block[9];
+        const int32_t bottom1 = block[8] - block[9];
+        out[0]          = toSample(descale(top0 + bottom0, 3));
+        out[1]          = toSample(descale(top1 + bottom1, 3));
+        out[stride]     = toSample(descale(top0 - bottom0, 3));
+        out[stride + 1] = toSample(descale(top1 - bottom1, 3));
+    }
+
+    auto loadRow(const FileParser::Jpeg::CoefficientBlock& block, const size_t row) -> simde__m128i {
+        return simde_mm_load_si128(reinterpret_cast<const simde__m128i*>(block.coefficients.data() + row * 8));
+    }
+}
+
+auto FileParser::Jpeg::inverseDCT(const CoefficientBlock& block, const uint8_t lastNonzero, uint8_t* out, const size_t stride) -> void {
+    constexpr int pass2Bits = constBits + pass1Bits + 3; // Also removes the factor of 8 the two passes leave on the samples
+
+    // Every sample of a DC-only block is the same, so work it out once as the two passes would
+    if (lastNonzero == 0) {
+        const int32_t pass1 = clampToInt16(block[0] * (1 << pass1Bits));
+        const uint8_t sample = toSample(std::clamp(descale(pass1 << constBits, pass2Bits), -128, 127));
+        for (size_t row = 0; row < 8; row++) {
+            std::memset(out + row * stride, sample, 8);
+        }
+        return;
+    }
+
+    // Zigzag indices up to 9 all lie within the top left 4x4 coefficients
+    constexpr uint8_t lastLowFrequencyIndex = 9;
+
+    Rows v;
+    for (size_t row = 0; row < 8; row++) {
+        v[row] = loadRow(block, row);
+    }
+
+    // Columns, then rows. Each pass works across registers, so transposing in between lines the data up
+    if (lastNonzero <= lastLowFrequencyIndex) {
+        // Rows and columns 4 to 7 are zero, which leaves v[4] to v[7] zero in both passes
+        idctPassLowFrequency<constBits - pass1Bits>(v);
+        transpose(v);
+        idctPassLowFrequency<pass2Bits>(v);
+    } else {
+        idctPass<constBits - pass1Bits>(v);
+        transpose(v);
+        idctPass<pass2Bits>(v);
+    }
+    transpose(v);
+
+    // Packing saturates to [-128, 127], then flipping the sign bit adds the level shift of 128
+    const simde__m128i levelShift = simde_mm_set1_epi8(static_cast<int8_t>(0x80));
+    for (size_t row = 0; row < 8; row += 2) {
+        const simde__m128i samples = simde_mm_xor_si128(simde_mm_packs_epi16(v[row], v[row + 1]), levelShift);
+        simde_mm_storel_epi64(reinterpret_cast<simde__m128i*>(out + row * stride), samples);
+        simde_mm_storel_epi64(reinterpret_cast<simde__m128i*>(out + (row + 1) * stride), simde_mm_unpackhi_epi64(samples, samples));
+    }
+}
+
+auto FileParser::Jpeg::inverseDCT(
+    const CoefficientBlock& block, const uint8_t lastNonzero, const size_t size, uint8_t* out, const size_t stride
+) -> void {
+    switch (size) {
+        case 1: *out = toSample(descale(block[0], 3)); break;
+        case 2: inverseDCT2x2(block, out, stride); break;
+        case 4: inverseDCT4x4(block, out, stride); break;
+        default: inverseDCT(block, lastNonzero, out, stride); break;
+    }
+}
+
+auto FileParser::Jpeg::inverseDCT(
+    const CoefficientPlane& plane, const size_t row, const size_t col, const size_t size, uint8_t* out, const size_t stride
+) -> void {
+    inverseDCT(plane.getBlock(row, col), plane.getLastNonzero(row, col), size, out, stride);
+}
@@ -0,0 +1,32 @@
+#include "FileParser/Jpeg/MarkerScanner.hpp"
+
+#include <bit>
+
+#include <simde/x86/sse2.h>
+
+#include "FileParser/Jpeg/Markers.hpp"
+
+auto FileParser::Jpeg::findMarkerHeader(const std::span<const uint8_t> bytes, const size_t from) -> size_t {
+    constexpr size_t vectorBytes = sizeof(simde__m128i);
+    const uint8_t* data = bytes.data();
+    size_t index = from;
+
+    // Entropy-coded data is mostly bytes other than 0xFF, so compare two vectors per iteration
+    const simde__m128i markerHeaders = simde_mm_set1_epi8(static_cast<int8_t>(MarkerHeader));
+    for (; index + 2 * vectorBytes <= bytes.size(); index += 2 * vectorBytes) {
+        const simde__m128i low  = simde_mm_loadu_si128(data + index);
+        const simde__m128i high = simde_mm_loadu_si128(data + index + vectorBytes);
+        const auto lowMask  = static_cast<uint32_t>(simde_mm_movemask_epi8(simde_mm_cmpeq_epi8(low,  markerHeaders)));
+        const auto highMask = static_cast<uint32_t>(simde_mm_movemask_epi8(simde_mm_cmpeq_epi8(high, markerHeaders)));
+        if (const uint32_t mask = lowMask | highMask << vectorBytes; mask != 0) {
+            return index + static_cast<size_t>(std::countr_zero(mask));
+        }
+    }
+
+    for (; index < bytes.size(); index++) {
+        if (data[index] == MarkerHeader) {
+            return index;
+        }
+    }
+    return bytes.size();
+}
@@ -23,21 +23,6 @@ void FileParser::Jpeg::RGBBlock::rgbToYCbCr() {
     }
 }
 
-size_t FileParser::Jpeg::Mcu::getColorIndex(const size_t blockIndex, const size_t pixelIndex) const {
-    const size_t blockRow = blockIndex / static_cast<size_t>(horizontalSampleSize);
-    const size_t blockCol = blockIndex % static_cast<size_t>(horizontalSampleSize);
-
-    constexpr size_t blockWidth  = 8;
-    constexpr size_t blockHeight = 8;
-    const size_t pixelRow = pixelIndex / blockWidth;
-    const size_t pixelCol = pixelIndex % blockWidth;
-
-    const size_t chromaRow = (blockRow * blockHeight + pixelRow) / static_cast<size_t>(verticalSampleSize);
-    const size_t chromaCol = (blockCol * blockWidth + pixelCol) / static_cast<size_t>(horizontalSampleSize);
-
-    return chromaRow * blockHeight + chromaCol;
-}
-
 FileParser::Jpeg::Mcu::Mcu() {
     Y.push_back({});
 }
@@ -1,7 +1,13 @@
 #include "FileParser/Jpeg/Transform.hpp"
 
+#include <algorithm>
+#include <optional>
+
 #include "FileParser/Macros.hpp"
-#include "FileParser/Utils.hpp"
+#include "FileParser/ThreadPool.hpp"
+#include "FileParser/Jpeg/ColorConvert.hpp"
+#include "FileParser/Jpeg/Idct.hpp"
+#include "FileParser/Jpeg/Upsample.hpp"
 
 // Uses AAN DCT
 void FileParser::Jpeg::inverseDCT(Component& array) //{
@@ -169,46 +175,12 @@ void FileParser::Jpeg::inverseDCT(Component& array) //{
     }
 }
 
-void FileParser::Jpeg::inverseDCT(Mcu& mcu) {
-    for (auto& y : mcu.Y) {
-        inverseDCT(y);
-    }
-    inverseDCT(mcu.Cb);
-    inverseDCT(mcu.Cr);
-}
-
 void FileParser::Jpeg::dequantize(Component& component, const QuantizationTable& quantizationTable) {
     for (size_t i = 0; i < Component::length; i++) {
         component[i] *= quantizationTable[i];
     }
 }
 
-auto FileParser::Jpeg::dequantize(
-    Mcu& mcu,
-    const FrameInfo& frame,
-    const ScanHeader& scanHeader,
-    const std::array<const QuantizationTable *, 4>& quantizationTables
-) -> std::expected<void, std::string> {
-    for (const auto& scanComp : scanHeader.components) {
-        ASSIGN_OR_RETURN(frameComp, frame.header.getComponent(scanComp.componentSelector), "");
-        const auto qTable = quantizationTables[frameComp.quantizationTableSelector];
-        if (qTable == nullptr) {
-            return std::unexpected("Quantization table was undefined");
-        }
-
-        if (scanComp.componentSelector == frame.luminanceID) {
-            for (auto& y : mcu.Y) {
-                dequantize(y, *qTable);
-            }
-        } else if (scanComp.componentSelector == frame.chrominanceBlueID) {
-            dequantize(mcu.Cb, *qTable);
-        } else if (scanComp.componentSelector == frame.chrominanceRedID) {
-            dequantize(mcu.Cr, *qTable);
-        }
-    }
-    return {};
-}
-
 void FileParser::Jpeg::forwardDCT(Component& component) {
     for (size_t i = 0; i < 8; ++i) {
         const float a0 = component[0 * 8 + i];
@@ -421,83 +393,397 @@ auto FileParser::Jpeg::RGBToYCbCr(const float r, const float g, const float b) -
     };
 }
 
-auto FileParser::Jpeg::generateColorBlocks(const Mcu& mcu) -> std::vector<RGBBlock> {
-    std::vector colorBlocks(mcu.Y.size(), RGBBlock());
-    for (size_t blockIndex = 0; blockIndex < mcu.Y.size(); blockIndex++) {
-        auto& [R, G, B] = colorBlocks[blockIndex];
-
-        for (size_t pixelIndex = 0; pixelIndex < Component::length; pixelIndex++) {
-            const size_t colorIndex = mcu.getColorIndex(blockIndex, pixelIndex);
-            auto [r, g, b] = YCbCrToRGB(mcu.Y[blockIndex][pixelIndex], mcu.Cb[colorIndex], mcu.Cr[colorIndex]);
-            R[pixelIndex] = r;
-            G[pixelIndex] = g;
-            B[pixelIndex] = b;
-        }
+auto FileParser::Jpeg::getMcuGeometry(const FrameInfo& frame, const DecodeScale scale) -> McuGeometry {
+    constexpr size_t blockSideLength = 8;
+    McuGeometry geometry;
+    geometry.blockSize = blockSideLength / static_cast<size_t>(scale);
+    geometry.width     = frame.luminanceHorizontalSamplingFactor * geometry.blockSize;
+    geometry.height    = frame.luminanceVerticalSamplingFactor   * geometry.blockSize;
+
+    // Chroma is sampled once per MCU, so when luma is scaled down chroma can use a larger IDCT than luma does. It
+    // grows while it still divides the MCU, so each chroma sample covers a whole number of pixels. With enough scaling
+    // that gives one chroma sample per pixel and no upsampling at all
+    geometry.chromaSize = geometry.blockSize;
+    while (geometry.chromaSize * 2 <= blockSideLength &&
+           geometry.width % (geometry.chromaSize * 2) == 0 && geometry.height % (geometry.chromaSize * 2) == 0) {
+        geometry.chromaSize *= 2;
     }
+    return geometry;
+}
 
-    return colorBlocks;
+auto FileParser::Jpeg::needsNeighbourColumns(const McuGeometry& geometry, const Upsampling upsampling) -> bool {
+    return upsampling == Upsampling::Fancy && geometry.horizontalRatio() == 2;
 }
 
-auto FileParser::Jpeg::convertMcusToColorBlocks(const std::vector<Mcu>& mcus, const size_t pixelWidth,
-                                                const size_t pixelHeight) -> std::vector<RGBBlock> {
-    if (mcus.empty()) {
+auto FileParser::Jpeg::needsNeighbourRows(const McuGeometry& geometry, const Upsampling upsampling) -> bool {
+    return upsampling == Upsampling::Fancy && geometry.verticalRatio() == 2;
+}
+
+namespace {
+    struct ComponentPlanes {
+        const FileParser::Jpeg::CoefficientPlane* luminance       = nullptr;
+        const FileParser::Jpeg::CoefficientPlane* chrominanceBlue = nullptr;
+        const FileParser::Jpeg::CoefficientPlane* chrominanceRed  = nullptr;
+    };
+
+    auto findComponentPlanes(
+        const std::vector<FileParser::Jpeg::CoefficientPlane>& planes, const FileParser::Jpeg::FrameInfo& frame
+    ) -> std::expected<ComponentPlanes, std::string> {
+        ComponentPlanes found;
+        for (size_t i = 0; i < frame.header.components.size() && i < planes.size(); i++) {
+            const auto& component = frame.header.components[i];
+            if      (component.identifier == frame.luminanceID)       found.luminance       = &planes[i];
+            else if (component.identifier == frame.chrominanceBlueID) found.chrominanceBlue = &planes[i];
+            else if (component.identifier == frame.chrominanceRedID)  found.chrominanceRed  = &planes[i];
+        }
+        if (found.luminance == nullptr || found.chrominanceBlue == nullptr || found.chrominanceRed == nullptr) {
+            return std::unexpected("Frame is missing a Y, Cb or Cr component");
+        }
+        return found;
+    }
+
+    // How many bands of consecutive MCU rows forEachMcuRow splits a frame into, one for each thread that can run at once
+    auto getMcuRowBandCount(const FileParser::Jpeg::FrameInfo& frame) -> size_t {
+        return std::min<size_t>(FileParser::ThreadPool::shared().getThreadCount() + 1, frame.mcuHeight);
+    }
+
+    // Runs convert(mcuRow, band) on every MCU row, with the bands in parallel, and returns the first error of any of them
+    template <typename Convert>
+    auto forEachMcuRow(const FileParser::Jpeg::FrameInfo& frame, const Convert& convert) -> std::expected<void, std::string> {
+        const size_t bandCount = getMcuRowBandCount(frame);
+        std::vector<std::optional<std::string>> errors(bandCount);
+        FileParser::ThreadPool::shared().parallelFor(bandCount, [&](const size_t band) {
+            const size_t endRow = frame.mcuHeight * (band + 1) / bandCount;
+            for (size_t mcuRow = frame.mcuHeight * band / bandCount; mcuRow < endRow; mcuRow++) {
+                if (const auto result = convert(mcuRow, band); !result) {
+                    errors[band] = result.error();
+                    return;
+                }
+            }
+        });
+        for (const auto& error : errors) {
+            if (error) {
+                return std::unexpected(*error);
+            }
+        }
         return {};
     }
 
-    constexpr size_t blockSideLength = 8;
-    const size_t blockWidth  = utils::ceilDivide(pixelWidth, blockSideLength);
-    const size_t blockHeight = utils::ceilDivide(pixelHeight, blockSideLength);
+    // Where convertMcuRowToPixels keeps the samples of the MCU columns a region touches
+    struct RegionColumns {
+        size_t firstMcuCol       = 0;
+        size_t endMcuCol         = 0;
+        size_t lumaLeft          = 0; // The image column of the first luma sample in a row
+        size_t lumaStride        = 0;
+        size_t chromaFirstMcuCol = 0;
+        size_t chromaEndMcuCol   = 0;
+        size_t chromaFirstCol    = 0; // The chroma column of the sample after the pad at index 0
+        size_t chromaStride      = 0;
+        size_t chromaRows        = 0;
+        size_t firstChromaCol    = 0; // The first chroma column under the region
+        size_t chromaCount       = 0;
+    };
 
-    const auto horizontal =  static_cast<size_t>(mcus[0].horizontalSampleSize);
-    const auto vertical   =  static_cast<size_t>(mcus[0].verticalSampleSize);
+    // Chroma covers the same MCU columns as luma, plus the columns either side when the triangle filter reads across
+    // them. Rows 1 to chromaSize are the MCU row itself, and the first and last rows are the chroma rows next to it
+    // above and below. Each row has one more sample at either end, for the filter to read at the edges of the image
+    auto getRegionColumns(
+        const FileParser::Jpeg::FrameInfo& frame,
+        const FileParser::Jpeg::McuGeometry& geometry,
+        const FileParser::Jpeg::Upsampling upsampling,
+        const FileParser::Jpeg::Region& region
+    ) -> RegionColumns {
+        const size_t firstCol        = region.x;
+        const size_t endCol          = static_cast<size_t>(region.x) + region.width;
+        const size_t horizontalRatio = geometry.horizontalRatio();
+        const bool   fancyColumns    = needsNeighbourColumns(geometry, upsampling);
+
+        RegionColumns columns;
+        columns.firstMcuCol       = firstCol / geometry.width;
+        columns.endMcuCol         = (endCol - 1) / geometry.width + 1;
+        columns.lumaLeft          = columns.firstMcuCol * geometry.width;
+        columns.lumaStride        = (columns.endMcuCol - columns.firstMcuCol) * geometry.width;
+        columns.chromaFirstMcuCol = fancyColumns && columns.firstMcuCol > 0 ? columns.firstMcuCol - 1 : columns.firstMcuCol;
+        columns.chromaEndMcuCol   = fancyColumns ? std::min<size_t>(columns.endMcuCol + 1, frame.mcuWidth) : columns.endMcuCol;
+        columns.chromaFirstCol    = columns.chromaFirstMcuCol * geometry.chromaSize;
+        columns.chromaStride      = (columns.chromaEndMcuCol - columns.chromaFirstMcuCol) * geometry.chromaSize + 2;
+        columns.chromaRows        = geometry.chromaSize + 2;
+        columns.firstChromaCol    = firstCol / horizontalRatio;
+        columns.chromaCount       = (endCol - 1) / horizontalRatio - columns.firstChromaCol + 1;
+        return columns;
+    }
+}
 
-    const size_t mcuTotalWidth  = utils::ceilDivide(blockWidth, static_cast<size_t>(horizontal));
-    std::vector result(blockWidth * blockHeight , RGBBlock());
+auto FileParser::Jpeg::createMcuRowScratch(
+    const FrameInfo& frame,
+    const DecodeScale scale,
+    const Upsampling upsampling,
+    const PixelFormat format,
+    const Region& region
+) -> McuRowScratch {
+    const McuGeometry geometry = getMcuGeometry(frame, scale);
+    const RegionColumns columns = getRegionColumns(frame, geometry, upsampling, region);
+    McuRowScratch scratch;
+    scratch.luma.resize(columns.lumaStride * geometry.height);
+    if (format == PixelFormat::Gray8) {
+        return scratch;
+    }
+    scratch.cb.resize(columns.chromaRows * columns.chromaStride);
+    scratch.cr.resize(columns.chromaRows * columns.chromaStride);
+    scratch.filtered.resize(needsNeighbourRows(geometry, upsampling) ? columns.chromaCount : 0);
+    scratch.upsampledCb.resize(columns.chromaCount * geometry.horizontalRatio());
+    scratch.upsampledCr.resize(columns.chromaCount * geometry.horizontalRatio());
+    return scratch;
+}
 
-    for (size_t mcuIndex = 0; mcuIndex < mcus.size(); mcuIndex++) {
-        const size_t mcuRow = mcuIndex / mcuTotalWidth;
-        const size_t mcuCol = mcuIndex % mcuTotalWidth;
+auto FileParser::Jpeg::convertMcuRowToPixels(
+    const std::vector<CoefficientPlane>& planes,
+    const FrameInfo& frame,
+    const DecodeScale scale,
+    const Upsampling upsampling,
+    const PixelFormat format,
+    const PlaneRows& planeRows,
+    const size_t imageMcuRow,
+    const Region& region,
+    const std::span<uint8_t> out,
+    const size_t outStride,
+    McuRowScratch& scratch
+) -> std::expected<void, std::string> {
+    ASSIGN_OR_PROPAGATE(components, findComponentPlanes(planes, frame));
+    const auto [luminance, chrominanceBlue, chrominanceRed] = components;
+
+    const size_t channels = getBytesPerPixel(format);
+    const McuGeometry geometry = getMcuGeometry(frame, scale);
+    const size_t horizontal      = frame.luminanceHorizontalSamplingFactor;
+    const size_t vertical        = frame.luminanceVerticalSamplingFactor;
+    const size_t horizontalRatio = geometry.horizontalRatio();
+    const size_t verticalRatio   = geometry.verticalRatio();
+    const bool   fancyColumns    = needsNeighbourColumns(geometry, upsampling);
+    const bool   fancyRows       = needsNeighbourRows(geometry, upsampling);
+    const RegionColumns columns  = getRegionColumns(frame, geometry, upsampling, region);
+
+    // The part of the region inside this MCU row, in pixels of the scaled image
+    const size_t mcuTop   = imageMcuRow * geometry.height;
+    const size_t firstRow = std::max<size_t>(mcuTop, region.y);
+    const size_t endRow   = std::min<size_t>(mcuTop + geometry.height, static_cast<size_t>(region.y) + region.height);
+    const size_t firstCol = region.x;
+    if (firstRow >= endRow) {
+        return {};
+    }
+    const size_t rowBytes = static_cast<size_t>(region.width) * channels;
+    if (outStride < rowBytes || out.size() < (endRow - firstRow - 1) * outStride + rowBytes) {
+        return std::unexpected("Output is too small for the MCU row");
+    }
+    const bool hasChroma = format != PixelFormat::Gray8;
+    if (scratch.luma.size() < columns.lumaStride * geometry.height ||
+        (hasChroma && (scratch.cb.size() < columns.chromaRows * columns.chromaStride ||
+                       scratch.upsampledCb.size() < columns.chromaCount * horizontalRatio))) {
+        return std::unexpected("Scratch rows are too small for the region");
+    }
+
+    // Luma of the MCU columns the region touches, one row per pixel row of the MCU row
+    const size_t firstMcuCol = columns.firstMcuCol;
+    const size_t lumaLeft    = columns.lumaLeft;
+    const size_t lumaStride  = columns.lumaStride;
+    auto& luma = scratch.luma;
+    for (size_t mcuCol = firstMcuCol; mcuCol < columns.endMcuCol; mcuCol++) {
+        for (size_t v = 0; v < vertical; v++) {
+            const size_t blockTop = mcuTop + v * geometry.blockSize;
+            if (blockTop >= endRow || blockTop + geometry.blockSize <= firstRow) {
+                continue;
+            }
+            for (size_t h = 0; h < horizontal; h++) {
+                const size_t offset = (blockTop - mcuTop) * lumaStride + (mcuCol - firstMcuCol) * geometry.width + h * geometry.blockSize;
+                inverseDCT(*luminance, planeRows.current * vertical + v, mcuCol * horizontal + h,
+                           geometry.blockSize, &luma[offset], lumaStride);
+            }
+        }
+    }
 
-        auto colors = generateColorBlocks(mcus[mcuIndex]);
-        for (size_t colorIndex = 0; colorIndex < colors.size(); colorIndex++) {
-            const size_t colorRow = colorIndex / horizontal;
-            const size_t colorCol = colorIndex % horizontal;
+    if (!hasChroma) {
+        for (size_t row = firstRow; row < endRow; row++) {
+            std::copy_n(&luma[(row - mcuTop) * lumaStride + (firstCol - lumaLeft)], region.width, &out[(row - firstRow) * outStride]);
+        }
+        return {};
+    }
 
-            const size_t blockRow = mcuRow * vertical   + colorRow;
-            const size_t blockCol = mcuCol * horizontal + colorCol;
+    // Chroma laid out as getRegionColumns describes
+    const size_t chromaSize     = geometry.chromaSize;
+    const size_t chromaFirstCol = columns.chromaFirstCol;
+    const size_t chromaStride   = columns.chromaStride;
+    const size_t chromaRows     = columns.chromaRows;
+
+    // Samples past the edges of the image only pad out the last MCUs, so the last samples inside it replace them
+    const size_t chromaWidth  = (getScaledSize(frame.header.numberOfSamplesPerLine, scale) + horizontalRatio - 1) / horizontalRatio;
+    const size_t chromaHeight = (getScaledSize(frame.header.numberOfLines, scale) + verticalRatio - 1) / verticalRatio;
+    const size_t imageChromaRows = std::min(chromaSize, chromaHeight - imageMcuRow * chromaSize);
+    const bool hasRowAbove = fancyRows && planeRows.above.has_value();
+    const bool hasRowBelow = fancyRows && planeRows.below.has_value() && imageChromaRows == chromaSize;
+
+    std::array<uint8_t, CoefficientBlock::length> blockSamples{};
+    const auto transformChroma = [&](const CoefficientPlane& plane, std::vector<uint8_t>& samples) {
+        for (size_t mcuCol = columns.chromaFirstMcuCol; mcuCol < columns.chromaEndMcuCol; mcuCol++) {
+            const size_t offset = 1 + (mcuCol - columns.chromaFirstMcuCol) * chromaSize;
+            inverseDCT(plane, planeRows.current, mcuCol, chromaSize, &samples[chromaStride + offset], chromaStride);
+            if (hasRowAbove) {
+                inverseDCT(plane, *planeRows.above, mcuCol, chromaSize, blockSamples.data(), chromaSize);
+                std::copy_n(&blockSamples[(chromaSize - 1) * chromaSize], chromaSize, &samples[offset]);
+            }
+            if (hasRowBelow) {
+                inverseDCT(plane, *planeRows.below, mcuCol, chromaSize, blockSamples.data(), chromaSize);
+                std::copy_n(blockSamples.data(), chromaSize, &samples[(chromaRows - 1) * chromaStride + offset]);
+            }
+        }
 
-            if (blockRow < blockHeight && blockCol < blockWidth) {
-                result[blockRow * blockWidth + blockCol] = colors[colorIndex];
+        const auto copyRow = [&](const size_t from, const size_t to) {
+            std::copy_n(&samples[from * chromaStride], chromaStride, &samples[to * chromaStride]);
+        };
+        if (!hasRowAbove) {
+            copyRow(1, 0);
+        }
+        for (size_t row = imageChromaRows + 1; row < (hasRowBelow ? chromaRows - 1 : chromaRows); row++) {
+            copyRow(imageChromaRows, row);
+        }
+        for (size_t row = 0; row < chromaRows; row++) {
+            uint8_t* rowSamples = &samples[row * chromaStride];
+            rowSamples[0] = rowSamples[1];
+            if (const size_t imageEnd = chromaWidth - chromaFirstCol + 1; imageEnd < chromaStride) {
+                std::fill(rowSamples + imageEnd, rowSamples + chromaStride, rowSamples[imageEnd - 1]);
+            }
+        }
+    };
+    transformChroma(*chrominanceBlue, scratch.cb);
+    transformChroma(*chrominanceRed,  scratch.cr);
+
+    // Upsamples the chroma samples under the region's columns into whole rows of pixels
+    const size_t firstChromaCol = columns.firstChromaCol;
+    const size_t chromaCount    = columns.chromaCount;
+    const size_t upsampledLeft  = firstChromaCol * horizontalRatio;
+    auto& filtered = scratch.filtered;
+    const auto upsampleRow = [&](const std::vector<uint8_t>& samples, const size_t rowInMcu, std::vector<uint8_t>& upsampled) -> const uint8_t* {
+        const uint8_t* near = &samples[(1 + rowInMcu / verticalRatio) * chromaStride + (firstChromaCol - chromaFirstCol + 1)];
+        if (fancyRows) {
+            const bool upper = rowInMcu % 2 == 0;
+            const uint8_t* far = upper ? near - chromaStride : near + chromaStride;
+            if (horizontalRatio == 2) {
+                upsampleFancy2x2(near, far, chromaCount, upsampled.data());
+                return upsampled.data();
+            }
+            upsampleFancyVertical(near, far, chromaCount, upper, horizontalRatio == 1 ? upsampled.data() : filtered.data());
+            if (horizontalRatio != 1) {
+                // libjpeg has no triangle filter for other horizontal ratios either, so those repeat samples
+                upsampleNearest(filtered.data(), chromaCount, horizontalRatio, upsampled.data());
             }
+            return upsampled.data();
         }
+        if (horizontalRatio == 1) {
+            return near;
+        }
+        if (horizontalRatio == 2) {
+            if (fancyColumns) upsampleFancy2x(near, chromaCount, upsampled.data());
+            else              upsampleNearest2x(near, chromaCount, upsampled.data());
+        } else {
+            upsampleNearest(near, chromaCount, horizontalRatio, upsampled.data());
+        }
+        return upsampled.data();
+    };
+
+    for (size_t row = firstRow; row < endRow; row++) {
+        const size_t rowInMcu = row - mcuTop;
+        const uint8_t* lumaRow = &luma[rowInMcu * lumaStride + (firstCol - lumaLeft)];
+        const uint8_t* cbRow   = upsampleRow(scratch.cb, rowInMcu, scratch.upsampledCb) + (firstCol - upsampledLeft);
+        const uint8_t* crRow   = upsampleRow(scratch.cr, rowInMcu, scratch.upsampledCr) + (firstCol - upsampledLeft);
+        convertYCbCrRow(lumaRow, cbRow, crRow, region.width, format, &out[(row - firstRow) * outStride]);
     }
-    return result;
+    return {};
 }
 
-auto FileParser::Jpeg::getRawRGBData(
-    const std::vector<RGBBlock>& colorBlocks, const size_t pixelWidth, const size_t pixelHeight
-) -> std::vector<uint8_t> {
-    std::vector<uint8_t> rgbData;
-    rgbData.reserve(pixelWidth * pixelHeight * 3);
+auto FileParser::Jpeg::convertPlanesToPixels(
+    const std::vector<CoefficientPlane>& planes,
+    const FrameInfo& frame,
+    const DecodeScale scale,
+    const Upsampling upsampling,
+    const PixelFormat format,
+    const OutputBuffer& output
+) -> std::expected<void, std::string> {
+    const Region image{
+        .width  = static_cast<uint32_t>(getScaledSize(frame.header.numberOfSamplesPerLine, scale)),
+        .height = static_cast<uint32_t>(getScaledSize(frame.header.numberOfLines, scale))
+    };
+    const size_t mcuHeight = getMcuGeometry(frame, scale).height;
+
+    // Each band of MCU rows reuses one set of working rows
+    std::vector<McuRowScratch> scratches(getMcuRowBandCount(frame), createMcuRowScratch(frame, scale, upsampling, format, image));
+    return forEachMcuRow(frame, [&](const size_t mcuRow, const size_t band) {
+        PlaneRows planeRows;
+        planeRows.current = mcuRow;
+        if (mcuRow > 0)                    planeRows.above = mcuRow - 1;
+        if (mcuRow + 1 < frame.mcuHeight)  planeRows.below = mcuRow + 1;
+
+        const size_t offset = mcuRow * mcuHeight * output.stride;
+        const auto out = std::span(output.data + offset, output.size - offset);
+        return convertMcuRowToPixels(planes, frame, scale, upsampling, format, planeRows, mcuRow, image, out, output.stride,
+                                     scratches[band]);
+    });
+}
 
-    constexpr size_t blockSideLength = 8;
-    const size_t blockWidth = utils::ceilDivide(pixelWidth, blockSideLength);
-    for (size_t y = 0; y < pixelHeight; y++) {
-        for (size_t x = 0; x < pixelWidth; x++) {
-            const size_t blockRow = y / blockSideLength;
-            const size_t blockCol = x / blockSideLength;
-
-            const size_t colorRow = y % blockSideLength;
-            const size_t colorCol = x % blockSideLength;
-
-            const size_t blockIndex = blockRow * blockWidth + blockCol;
-            const size_t colorIndex = colorRow * blockSideLength + colorCol;
-
-            const auto& [R, G, B] = colorBlocks[blockIndex];
-            rgbData.push_back(static_cast<uint8_t>(std::clamp(R[colorIndex], 0.0f, 255.0f)));
-            rgbData.push_back(static_cast<uint8_t>(std::clamp(G[colorIndex], 0.0f, 255.0f)));
-            rgbData.push_back(static_cast<uint8_t>(std::clamp(B[colorIndex], 0.0f, 255.0f)));
+auto FileParser::Jpeg::convertPlanesToYCbCr(
+    const std::vector<CoefficientPlane>& planes,
+    const FrameInfo& frame,
+    const DecodeScale scale
+) -> std::expected<YCbCrImage, std::string> {
+    ASSIGN_OR_PROPAGATE(components, findComponentPlanes(planes, frame));
+    const McuGeometry geometry = getMcuGeometry(frame, scale);
+    const size_t horizontal = frame.luminanceHorizontalSamplingFactor;
+    const size_t vertical   = frame.luminanceVerticalSamplingFactor;
+
+    const auto makePlane = [](const size_t width, const size_t height) {
+        return ImagePlane{
+            .width  = static_cast<uint32_t>(width),
+            .height = static_cast<uint32_t>(height),
+            .data   = std::vector<uint8_t>(width * height)
+        };
+    };
+    const size_t width  = getScaledSize(frame.header.numberOfSamplesPerLine, scale);
+    const size_t height = getScaledSize(frame.header.numberOfLines, scale);
+    YCbCrImage image{
+        .y  = makePlane(width, height),
+        .cb = makePlane((width + geometry.horizontalRatio() - 1) / geometry.horizontalRatio(),
+                        (height + geometry.verticalRatio() - 1) / geometry.verticalRatio()),
+        .cr = {}
+    };
+    image.cr = makePlane(image.cb.width, image.cb.height);
+
+    // Transforms a block into a plane, dropping the samples that pad the last MCUs out past the edges of the image
+    const auto transformBlock = [](const CoefficientPlane& blocks, const size_t blockRow, const size_t blockCol, const size_t size,
+                                   ImagePlane& plane, const size_t left, const size_t top,
+                                   std::array<uint8_t, CoefficientBlock::length>& samples) {
+        if (left >= plane.width || top >= plane.height) {
+            return;
         }
-    }
-    return rgbData;
+        inverseDCT(blocks, blockRow, blockCol, size, samples.data(), size);
+        const size_t columns = std::min<size_t>(size, plane.width - left);
+        const size_t rows    = std::min<size_t>(size, plane.height - top);
+        for (size_t row = 0; row < rows; row++) {
+            std::copy_n(&samples[row * size], columns, &plane.data[(top + row) * plane.width + left]);
+        }
+    };
+
+    CHECK_VOID_OR_PROPAGATE(forEachMcuRow(frame, [&](const size_t mcuRow, size_t) -> std::expected<void, std::string> {
+        std::array<uint8_t, CoefficientBlock::length> samples{};
+        for (size_t mcuCol = 0; mcuCol < frame.mcuWidth; mcuCol++) {
+            for (size_t v = 0; v < vertical; v++) {
+                for (size_t h = 0; h < horizontal; h++) {
+                    transformBlock(*components.luminance, mcuRow * vertical + v, mcuCol * horizontal + h, geometry.blockSize,
+                                   image.y, mcuCol * geometry.width + h * geometry.blockSize, mcuRow * geometry.height + v * geometry.blockSize, samples);
+                }
+            }
+            const size_t chromaLeft = mcuCol * geometry.chromaSize;
+            const size_t chromaTop  = mcuRow * geometry.chromaSize;
+            transformBlock(*components.chrominanceBlue, mcuRow, mcuCol, geometry.chromaSize, image.cb, chromaLeft, chromaTop, samples);
+            transformBlock(*components.chrominanceRed,  mcuRow, mcuCol, geometry.chromaSize, image.cr, chromaLeft, chromaTop, samples);
+        }
+        return {};
+    }));
+    return image;
 }
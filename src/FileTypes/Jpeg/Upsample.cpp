@@ -0,0 +1,104 @@
+#include "FileParser/Jpeg/Upsample.hpp"
+
+#include <cstddef>
+#include <cstring>
+
+#include <simde/x86/sse2.h>
+
+namespace {
+    // Eight samples from p, widened to 16 bits
+    auto loadWide(const uint8_t* p) -> simde__m128i {
+        return simde_mm_unpacklo_epi8(simde_mm_loadl_epi64(reinterpret_cast<const simde__m128i*>(p)), simde_mm_setzero_si128());
+    }
+
+    auto times3(const simde__m128i x) -> simde__m128i {
+        return simde_mm_add_epi16(simde_mm_add_epi16(x, x), x);
+    }
+
+    // Packs two vectors of eight even and eight odd outputs into sixteen interleaved samples
+    auto storeInterleaved(uint8_t* out, const simde__m128i even, const simde__m128i odd) -> void {
+        const simde__m128i zero = simde_mm_setzero_si128();
+        simde_mm_storeu_si128(reinterpret_cast<simde__m128i*>(out),
+            simde_mm_unpacklo_epi8(simde_mm_packus_epi16(even, zero), simde_mm_packus_epi16(odd, zero)));
+    }
+}
+
+auto FileParser::Jpeg::upsampleNearest2x(const uint8_t* in, const size_t count, uint8_t* out) -> void {
+    constexpr size_t vectorBytes = sizeof(simde__m128i);
+    size_t i = 0;
+    for (; i + vectorBytes <= count; i += vectorBytes) {
+        const simde__m128i samples = simde_mm_loadu_si128(reinterpret_cast<const simde__m128i*>(in + i));
+        simde_mm_storeu_si128(reinterpret_cast<simde__m128i*>(out + 2 * i),               simde_mm_unpacklo_epi8(samples, samples));
+        simde_mm_storeu_si128(reinterpret_cast<simde__m128i*>(out + 2 * i + vectorBytes), simde_mm_unpackhi_epi8(samples, samples));
+    }
+    for (; i < count; i++) {
+        out[2 * i] = out[2 * i + 1] = in[i];
+    }
+}
+
+auto FileParser::Jpeg::upsampleNearest(const uint8_t* in, const size_t count, const size_t factor, uint8_t* out) -> void {
+    for (size_t i = 0; i < count; i++) {
+        std::memset(out + i * factor, in[i], factor);
+    }
+}
+
+auto FileParser::Jpeg::upsampleFancy2x(const uint8_t* in, const size_t count, uint8_t* out) -> void {
+    const simde__m128i one = simde_mm_set1_epi16(1);
+    const simde__m128i two = simde_mm_set1_epi16(2);
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        const uint8_t* samples = in + i;
+        const simde__m128i nearest = times3(loadWide(samples));
+        const simde__m128i even = simde_mm_srli_epi16(simde_mm_add_epi16(simde_mm_add_epi16(nearest, loadWide(samples - 1)), one), 2);
+        const simde__m128i odd  = simde_mm_srli_epi16(simde_mm_add_epi16(simde_mm_add_epi16(nearest, loadWide(samples + 1)), two), 2);
+        storeInterleaved(out + 2 * i, even, odd);
+    }
+    for (; i < count; i++) {
+        const uint8_t* sample = in + i;
+        const int nearest = 3 * sample[0];
+        out[2 * i]     = static_cast<uint8_t>((nearest + sample[-1] + 1) >> 2);
+        out[2 * i + 1] = static_cast<uint8_t>((nearest + sample[1]  + 2) >> 2);
+    }
+}
+
+auto FileParser::Jpeg::upsampleFancyVertical(
+    const uint8_t* near, const uint8_t* far, const size_t count, const bool upper, uint8_t* out
+) -> void {
+    const int bias = upper ? 1 : 2;
+    const simde__m128i biasVector = simde_mm_set1_epi16(static_cast<int16_t>(bias));
+    const simde__m128i zero = simde_mm_setzero_si128();
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        const simde__m128i sum = simde_mm_add_epi16(simde_mm_add_epi16(times3(loadWide(near + i)), loadWide(far + i)), biasVector);
+        simde_mm_storel_epi64(reinterpret_cast<simde__m128i*>(out + i), simde_mm_packus_epi16(simde_mm_srli_epi16(sum, 2), zero));
+    }
+    for (; i < count; i++) {
+        out[i] = static_cast<uint8_t>((3 * near[i] + far[i] + bias) >> 2);
+    }
+}
+
+auto FileParser::Jpeg::upsampleFancy2x2(const uint8_t* near, const uint8_t* far, const size_t count, uint8_t* out) -> void {
+    // The vertical filter first, keeping the column sums at 4x scale, then the horizontal filter on those
+    const auto columnSums = [&](const uint8_t* nearSamples, const uint8_t* farSamples) {
+        return simde_mm_add_epi16(times3(loadWide(nearSamples)), loadWide(farSamples));
+    };
+    const simde__m128i eight = simde_mm_set1_epi16(8);
+    const simde__m128i seven = simde_mm_set1_epi16(7);
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        const uint8_t* nearSamples = near + i;
+        const uint8_t* farSamples  = far  + i;
+        const simde__m128i nearest = times3(columnSums(nearSamples, farSamples));
+        const simde__m128i even = simde_mm_srli_epi16(simde_mm_add_epi16(simde_mm_add_epi16(nearest, columnSums(nearSamples - 1, farSamples - 1)), eight), 4);
+        const simde__m128i odd  = simde_mm_srli_epi16(simde_mm_add_epi16(simde_mm_add_epi16(nearest, columnSums(nearSamples + 1, farSamples + 1)), seven), 4);
+        storeInterleaved(out + 2 * i, even, odd);
+    }
+    for (; i < count; i++) {
+        const uint8_t* nearSamples = near + i;
+        const uint8_t* farSamples  = far  + i;
+        const auto columnSum = [&](const ptrdiff_t offset) { return 3 * nearSamples[offset] + farSamples[offset]; };
+        const int nearest = 3 * columnSum(0);
+        out[2 * i]     = static_cast<uint8_t>((nearest + columnSum(-1) + 8) >> 4);
+        out[2 * i + 1] = static_cast<uint8_t>((nearest + columnSum(1)  + 7) >> 4);
+    }
+}
@@ -44,6 +44,16 @@ FileUtils::FileType FileUtils::getFileType(const std::string& filePath) {
     return FileType::None;
 }
 
+FileUtils::FileType FileUtils::getFileType(const std::span<const uint8_t> bytes) {
+    if (matchesSignature(bmpSig, bytes)) {
+        return FileType::Bmp;
+    }
+    if (matchesSignature(jpegSig, bytes)) {
+        return FileType::Jpeg;
+    }
+    return FileType::None;
+}
+
 FileUtils::FileType FileUtils::stringToFileType(const std::string& str) {
     const std::string copy = ToLower(str);
     if (copy == "jpeg" || copy == "jpg") {
@@ -74,6 +84,44 @@ auto FileUtils::openRegularFile(
     return file;
 }
 
+auto FileUtils::readFileBytes(const std::filesystem::path& filePath) -> std::expected<std::vector<uint8_t>, std::string> {
+    auto file = openRegularFile(filePath, std::ios::binary);
+    if (!file) {
+        return std::unexpected(file.error());
+    }
+
+    file->seekg(0, std::ios::end);
+    const std::streampos size = file->tellg();
+    if (size < 0) {
+        return std::unexpected("Failed to determine size of file: " + filePath.string());
+    }
+    file->seekg(0, std::ios::beg);
+
+    std::vector<uint8_t> bytes(static_cast<size_t>(size));
+    if (!file->read(reinterpret_cast<char *>(bytes.data()), size)) {
+        return std::unexpected("Failed to read file: " + filePath.string());
+    }
+    return bytes;
+}
+
+auto FileUtils::readFilePrefix(
+    const std::filesystem::path& filePath,
+    const size_t maxBytes
+) -> std::expected<std::vector<uint8_t>, std::string> {
+    auto file = openRegularFile(filePath, std::ios::binary);
+    if (!file) {
+        return std::unexpected(file.error());
+    }
+
+    std::vector<uint8_t> bytes(maxBytes);
+    file->read(reinterpret_cast<char *>(bytes.data()), static_cast<std::streamsize>(maxBytes));
+    if (file->bad()) {
+        return std::unexpected("Failed to read file: " + filePath.string());
+    }
+    bytes.resize(static_cast<size_t>(file->gcount()));
+    return bytes;
+}
+
 auto FileUtils::openRegularFileForWrite(
     const std::filesystem::path& filePath,
     const std::ios::openmode mode
@@ -1,22 +1,7 @@
 #include "FileParser/Huffman/Table.hpp"
 
+#include <algorithm>
 #include <array>
-#include <iostream>
-
-FileParser::HuffmanSubtable::HuffmanSubtable(const HuffmanSubtable& other) {
-    if (other.table != nullptr) {
-        table = std::make_unique<std::array<HuffmanTableEntry, 256>>(*other.table);
-    }
-}
-
-FileParser::HuffmanSubtable& FileParser::HuffmanSubtable::operator=(const HuffmanSubtable& other) {
-    if (this != &other) {
-        if (other.table != nullptr) {
-            table = std::make_unique<std::array<HuffmanTableEntry, 256>>(*other.table);
-        }
-    }
-    return *this;
-}
 
 FileParser::HuffmanTable::HuffmanTable(const std::vector<HuffmanEncoding>& encodings_) {
     this->encodings = encodings_;
@@ -24,21 +9,22 @@ FileParser::HuffmanTable::HuffmanTable(const std::vector<HuffmanEncoding>& encod
         m_encodingLookup.insert(std::make_pair(encoding.value, encoding));
     }
     generateLookupTable(encodings_);
+    generateMaxCodeTable(encodings_);
+    generateFusedLookupTable();
 }
 
 auto FileParser::HuffmanTable::decode(const uint16_t word) const -> std::pair<uint8_t, uint8_t> {
-    const auto& decoding = (*m_table.table)[static_cast<uint8_t>(word >> 8 & 0xFF)];
-    if (decoding.nestedTable.table == nullptr) {
-        if (decoding.bitLength == 0) {
-            std::cerr << "Huffman encoding does not exist!\n";
-        }
+    const auto& decoding = m_lookup[word >> (maxEncodingLength - lookupBits)];
+    if (decoding.bitLength != 0) {
         return {decoding.bitLength, decoding.value};
     }
-    const auto& decoding2 = (*decoding.nestedTable.table)[static_cast<uint8_t>(word & 0xFF)];
-    if (decoding2.nestedTable.table == nullptr && decoding2.bitLength == 0) {
-        std::cerr << "Huffman encoding does not exist!\n";
+    for (size_t length = lookupBits + 1; length <= maxEncodingLength; length++) {
+        const auto code = static_cast<int32_t>(word >> (maxEncodingLength - length));
+        if (code <= m_maxCode[length]) {
+            return {static_cast<uint8_t>(length), m_values[static_cast<size_t>(code - m_valueOffset[length])]};
+        }
     }
-    return {decoding2.bitLength, decoding2.value};
+    return {0, 0};
 }
 
 // Used in the Encoder to find the encoding for a symbol
@@ -46,27 +32,58 @@ auto FileParser::HuffmanTable::encode(const uint8_t symbol) const -> HuffmanEnco
     return m_encodingLookup.at(symbol);
 }
 
-// Main function that generates label
+// Fills every slot of the lookup table whose leading bits are a code of at most lookupBits bits
 void FileParser::HuffmanTable::generateLookupTable(const std::vector<HuffmanEncoding>& encodingsVec) {
-    m_table.table = std::make_unique<std::array<HuffmanTableEntry, 256>>();
     for (const auto& encoding : encodingsVec) {
-        if (encoding.bitLength <= 8) {
-            const auto leftShifted = static_cast<uint8_t>(encoding.encoding << (8 - encoding.bitLength));
-            for (uint8_t i = 0; i < static_cast<uint8_t>(1 << (8 - encoding.bitLength)); i++) {
-                const uint8_t index = i | leftShifted;
-                (*m_table.table)[index] = HuffmanTableEntry(encoding.bitLength, encoding.value);
-            }
-        } else {
-            const auto partOne = static_cast<uint8_t>(encoding.encoding >> (encoding.bitLength - 8) & 0xFF);
-            const auto partTwo = static_cast<uint8_t>(encoding.encoding << (maxEncodingLength - encoding.bitLength) & 0xFF);
-            if ((*m_table.table)[partOne].nestedTable.table == nullptr) {
-                (*m_table.table)[partOne].nestedTable.table = std::make_unique<std::array<HuffmanTableEntry, 256>>();
-            }
-            const auto partTwoTable = (*m_table.table)[partOne].nestedTable.table.get();
-            for (uint8_t i = 0; i < static_cast<uint8_t>(1 << (16 - encoding.bitLength)); i++) {
-                const uint8_t index = i | partTwo;
-                (*partTwoTable)[index] = HuffmanTableEntry(encoding.bitLength, encoding.value);
+        if (encoding.bitLength == 0 || encoding.bitLength > lookupBits) continue;
+        if (encoding.encoding >> encoding.bitLength != 0) continue; // Not a code of its length, so it has no slots
+        const size_t unusedBits = lookupBits - encoding.bitLength;
+        const size_t first = static_cast<size_t>(encoding.encoding) << unusedBits;
+        for (size_t i = 0; i < size_t{1} << unusedBits; i++) {
+            m_lookup[first | i] = HuffmanLookupEntry{.bitLength = encoding.bitLength, .value = encoding.value};
+        }
+    }
+}
+
+// Codes of each length are consecutive in a canonical Huffman code, so one range check per length finds long codes
+void FileParser::HuffmanTable::generateMaxCodeTable(const std::vector<HuffmanEncoding>& encodingsVec) {
+    std::vector<HuffmanEncoding> sorted = encodingsVec;
+    std::ranges::sort(sorted, [](const HuffmanEncoding& a, const HuffmanEncoding& b) {
+        return a.bitLength != b.bitLength ? a.bitLength < b.bitLength : a.encoding < b.encoding;
+    });
+
+    m_maxCode.fill(-1);
+    m_valueOffset.fill(0);
+    m_values.clear();
+    m_values.reserve(sorted.size());
+    for (const auto& encoding : sorted) {
+        if (encoding.bitLength == 0 || encoding.bitLength > maxEncodingLength) continue;
+        if (m_maxCode[encoding.bitLength] == -1) {
+            m_valueOffset[encoding.bitLength] = static_cast<int32_t>(encoding.encoding) - static_cast<int32_t>(m_values.size());
+        }
+        m_maxCode[encoding.bitLength] = encoding.encoding;
+        m_values.push_back(encoding.value);
+    }
+}
+
+// Interprets symbols as JPEG RRRRSSSS pairs, and resolves the SSSS extra bits whenever they fit after the code
+void FileParser::HuffmanTable::generateFusedLookupTable() {
+    for (size_t index = 0; index < lookupSize; index++) {
+        const auto& [codeLength, symbol] = m_lookup[index];
+        const size_t extraBits = symbol & 0x0F;
+        if (codeLength == 0 || codeLength + extraBits > lookupBits) continue;
+
+        int coefficient = 0;
+        if (extraBits != 0) {
+            coefficient = static_cast<int>((index >> (lookupBits - codeLength - extraBits)) & ((size_t{1} << extraBits) - 1));
+            if (coefficient < 1 << (extraBits - 1)) {
+                coefficient -= (1 << extraBits) - 1;
             }
         }
+        m_fusedLookup[index] = HuffmanFusedEntry{
+            .bitLength = static_cast<uint8_t>(codeLength + extraBits),
+            .value = symbol,
+            .coefficient = static_cast<int16_t>(coefficient)
+        };
     }
 }
@@ -3,7 +3,7 @@
 #include <algorithm>
 
 uint8_t& FileParser::getPixel(Image& image, const uint32_t x, const uint32_t y, const uint32_t channel) {
-    constexpr size_t numChannels = 3;
+    const size_t numChannels = getBytesPerPixel(image.format);
     return image.data[y * image.width * numChannels + x * numChannels + channel];
 }
 
@@ -18,7 +18,7 @@ void swapPixel(
 }
 
 void FileParser::flipVertically(Image& image) {
-    const size_t bytesPerRow = image.width * 3;
+    const size_t bytesPerRow = image.width * getBytesPerPixel(image.format);
     for (uint32_t y = 0; y < image.height / 2; y++) {
         const auto topRow = image.data.begin() + static_cast<std::ptrdiff_t>(y * bytesPerRow);
         const auto bottomRow = image.data.begin() + static_cast<std::ptrdiff_t>((image.height - y - 1) * bytesPerRow);
@@ -27,7 +27,7 @@ void FileParser::flipVertically(Image& image) {
 }
 
 void FileParser::flipHorizontally(Image& image) {
-    constexpr size_t numChannels = 3;
+    const auto numChannels = static_cast<uint32_t>(getBytesPerPixel(image.format));
     for (uint32_t x = 0; x < image.width / 2; x++) {
         for (uint32_t y = 0; y < image.height; y++) {
             swapPixel(image, x, y, image.width - 1 - x, y, numChannels);
@@ -0,0 +1,99 @@
+#include "FileParser/ThreadPool.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <memory>
+
+FileParser::ThreadPool::ThreadPool(const size_t threadCount) {
+    m_workers.reserve(threadCount);
+    for (size_t i = 0; i < threadCount; i++) {
+        m_workers.emplace_back([this](const std::stop_token& stopToken) { workerLoop(stopToken); });
+    }
+}
+
+FileParser::ThreadPool::~ThreadPool() {
+    for (auto& worker : m_workers) {
+        worker.request_stop();
+    }
+    m_condition.notify_all();
+    // std::jthread joins on destruction
+}
+
+auto FileParser::ThreadPool::shared() -> ThreadPool& {
+    static ThreadPool pool(std::max(std::thread::hardware_concurrency(), 1u) - 1);
+    return pool;
+}
+
+auto FileParser::ThreadPool::getThreadCount() const -> size_t {
+    return m_workers.size();
+}
+
+auto FileParser::ThreadPool::submit(std::function<void()> job) -> void {
+    {
+        std::lock_guard lock(m_mutex);
+        m_jobs.push_back(std::move(job));
+    }
+    m_condition.notify_one();
+}
+
+auto FileParser::ThreadPool::workerLoop(const std::stop_token& stopToken) -> void {
+    while (true) {
+        std::function<void()> job;
+        {
+            std::unique_lock lock(m_mutex);
+            if (!m_condition.wait(lock, stopToken, [this] { return !m_jobs.empty(); })) {
+                return;
+            }
+            job = std::move(m_jobs.front());
+            m_jobs.pop_front();
+        }
+        job();
+    }
+}
+
+auto FileParser::ThreadPool::parallelFor(const size_t count, const std::function<void(size_t)>& task) -> void {
+    if (count == 0) return;
+
+    // Shared with the helper jobs, which may only get scheduled after the caller has already returned
+    struct State {
+        std::atomic<size_t> nextIndex = 0;
+        std::mutex mutex;
+        std::condition_variable finished;
+        size_t completed = 0;
+        std::exception_ptr exception = nullptr;
+    };
+    const auto state = std::make_shared<State>();
+
+    auto runTasks = [state, count, &task] {
+        size_t ranHere = 0;
+        std::exception_ptr exception = nullptr;
+        for (size_t i = state->nextIndex++; i < count; i = state->nextIndex++) {
+            try {
+                task(i);
+            } catch (...) {
+                if (!exception) exception = std::current_exception();
+            }
+            ranHere++;
+        }
+        if (ranHere == 0) return;
+
+        std::lock_guard lock(state->mutex);
+        if (exception && !state->exception) state->exception = exception;
+        state->completed += ranHere;
+        if (state->completed == count) state->finished.notify_all();
+    };
+
+    // A helper that starts after all indices are taken returns without touching the task
+    const size_t helpers = std::min(getThreadCount(), count - 1);
+    for (size_t i = 0; i < helpers; i++) {
+        submit(runTasks);
+    }
+    runTasks();
+
+    std::unique_lock lock(state->mutex);
+    state->finished.wait(lock, [&] { return state->completed == count; });
+    if (state->exception) {
+        std::rethrow_exception(state->exception);
+    }
+}